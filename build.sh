@@ -1,2 +1,17 @@
 mkdir -p build
-g++ -std=c++20 -O3 -march=native -DNDEBUG -pthread -Isrc src/main.cpp src/uci.cpp src/search.cpp src/eval.cpp src/pst.cpp -o build/minerva
+# ./build.sh debug: assertions on (e.g. incremental eval vs full recompute)
+# ./build.sh stats: search counters on (see src/stats.hpp), reported by `stats`
+# ./build.sh test: also build and run the C++ tests in tests/
+if [ "$1" = "debug" ] || [ "$1" = "test" ]; then
+    FLAGS="-O1 -g"
+elif [ "$1" = "stats" ]; then
+    FLAGS="-O3 -march=native -DNDEBUG -DMINERVA_STATS"
+else
+    FLAGS="-O3 -march=native -DNDEBUG"
+fi
+# Fathom (Syzygy probing) is C
+gcc $FLAGS -c src/external/fathom/src/tbprobe.c -o build/tbprobe.o
+g++ -std=c++20 $FLAGS -pthread -Isrc src/main.cpp src/uci.cpp src/search.cpp src/tt.cpp src/eval.cpp src/pst.cpp src/microbench.cpp src/thread_pool.cpp src/bench.cpp src/perft.cpp src/timeman.cpp src/analyse.cpp src/match.cpp src/stats.cpp src/nnue.cpp src/syzygy.cpp src/book.cpp src/output.cpp build/tbprobe.o -o build/minerva
+if [ "$1" = "test" ]; then
+    g++ -std=c++20 $FLAGS -pthread -Isrc tests/search_alloc_test.cpp src/uci.cpp src/search.cpp src/tt.cpp src/eval.cpp src/pst.cpp src/microbench.cpp src/thread_pool.cpp src/bench.cpp src/perft.cpp src/timeman.cpp src/analyse.cpp src/match.cpp src/stats.cpp src/nnue.cpp src/syzygy.cpp src/book.cpp src/output.cpp build/tbprobe.o -o build/search_alloc_test && build/search_alloc_test
+fi
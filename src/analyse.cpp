@@ -0,0 +1,240 @@
+#include "analyse.hpp"
+#include "mapped_file.hpp"
+#include "search.hpp"
+#include "syzygy.hpp"
+#include "tt.hpp"
+#include "uci.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace chess;
+
+namespace {
+
+// Fixed-capacity blocking queue; pop() fails once closed and drained
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+    void push(T v) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        notFull_.wait(lk, [this] { return items_.size() < capacity_; });
+        items_.push_back(std::move(v));
+        notEmpty_.notify_one();
+    }
+
+    bool pop(T& v) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        notEmpty_.wait(lk, [this] { return !items_.empty() || closed_; });
+        if (items_.empty()) return false;
+        v = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lk(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable notFull_, notEmpty_;
+    std::deque<T> items_;
+    size_t capacity_;
+    bool closed_ = false;
+};
+
+struct Job {
+    size_t line = 0;
+    std::string_view text; // points into the mapped input
+};
+
+bool is_number(std::string_view s) {
+    return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+void append_json_string(std::string& out, std::string_view s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if ((unsigned char)c < 0x20) out += ' ';
+        else out += c;
+    }
+    out += '"';
+}
+
+} // namespace
+
+namespace analyse {
+
+bool parse_epd(std::string_view line, std::string& fen, std::string& id) {
+    std::vector<std::string_view> tok;
+    size_t pos = 0;
+    while (pos < line.size() && tok.size() < 6) {
+        while (pos < line.size() && line[pos] == ' ') ++pos;
+        size_t end = line.find(' ', pos);
+        if (end == std::string_view::npos) end = line.size();
+        if (end > pos) tok.push_back(line.substr(pos, end - pos));
+        pos = end;
+    }
+    if (tok.size() < 4) return false;
+    if (std::count(tok[0].begin(), tok[0].end(), '/') != 7) return false;
+    if (tok[1] != "w" && tok[1] != "b") return false;
+
+    fen.assign(tok[0]);
+    for (int i = 1; i < 4; ++i) fen.append(" ").append(tok[i]);
+    if (tok.size() >= 6 && is_number(tok[4]) && is_number(tok[5]))
+        fen.append(" ").append(tok[4]).append(" ").append(tok[5]);
+    else
+        fen.append(" 0 1");
+
+    id.clear();
+    size_t idPos = line.find("id \"");
+    if (idPos != std::string_view::npos) {
+        size_t start = idPos + 4, end = line.find('"', start);
+        if (end != std::string_view::npos) id.assign(line.substr(start, end - start));
+    }
+    return true;
+}
+
+bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) return false;
+        std::string v = argv[++i];
+        try {
+            if (a == "--epd") opt.epd = v;
+            else if (a == "--out") opt.out = v;
+            else if (a == "--depth") opt.depth = std::stoi(v);
+            else if (a == "--jobs") opt.jobs = std::stoi(v);
+            else if (a == "--hash") opt.hashMB = (size_t)std::max(1, std::stoi(v));
+            else if (a == "--syzygy") opt.syzygy = v;
+            else return false;
+        } catch (...) {
+            return false;
+        }
+    }
+    return !opt.epd.empty();
+}
+
+int run(const Options& opt) {
+    MappedFile input(opt.epd);
+    if (!input.ok()) {
+        std::cerr << "analyse: cannot read " << opt.epd << "\n";
+        return 1;
+    }
+
+    std::ofstream file;
+    std::ostream* out = &std::cout;
+    if (opt.out != "-") {
+        file.open(opt.out, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "analyse: cannot write " << opt.out << "\n";
+            return 1;
+        }
+        out = &file;
+    }
+
+    if (!opt.syzygy.empty() && syzygy::init(opt.syzygy) == 0)
+        std::cerr << "analyse: no Syzygy tablebases found in " << opt.syzygy << "\n";
+
+    const int jobs = opt.jobs > 0 ? opt.jobs : std::max(1, (int)std::thread::hardware_concurrency());
+    const int depth = std::clamp(opt.depth, 1, ::utils::MAX_PLY - 1);
+
+    BoundedQueue<Job> queue((size_t)jobs * 4);
+    std::mutex outMutex;
+    std::atomic<uint64_t> positions{0}, totalNodes{0};
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int j = 0; j < jobs; ++j) {
+        workers.emplace_back([&] {
+            TranspositionTable tt(opt.hashMB);
+            auto search = std::make_unique<Search>(tt);
+            SearchLimits lim;
+            lim.depth = depth;
+            lim.timeMs = std::numeric_limits<int>::max();
+            lim.quiet = true;
+
+            std::string fen, id, line;
+            Job job;
+            while (queue.pop(job)) {
+                line.clear();
+                line += "{\"line\":" + std::to_string(job.line);
+                if (!parse_epd(job.text, fen, id)) {
+                    line += ",\"error\":\"not a position\"}\n";
+                } else {
+                    Board b(fen);
+                    tt.new_generation();
+                    SearchResult r = search->go(b, lim);
+                    totalNodes.fetch_add(search->nodes(), std::memory_order_relaxed);
+
+                    line += ",\"fen\":";
+                    append_json_string(line, fen);
+                    if (!id.empty()) {
+                        line += ",\"id\":";
+                        append_json_string(line, id);
+                    }
+                    line += ",\"bestmove\":";
+                    append_json_string(line, r.best == Move::NO_MOVE ? "0000" : UciDriver::move_to_uci(r.best));
+                    line += ::utils::is_mate_score(r.bestScore)
+                        ? ",\"score\":{\"mate\":" + std::to_string(::utils::mate_moves(r.bestScore)) + "}"
+                        : ",\"score\":{\"cp\":" + std::to_string(r.bestScore) + "}";
+                    line += ",\"depth\":" + std::to_string(r.depth);
+                    line += ",\"nodes\":" + std::to_string(search->nodes());
+                    line += ",\"pv\":\"";
+                    for (size_t i = 0; i < r.pv.size(); ++i) {
+                        if (i) line += ' ';
+                        line += UciDriver::move_to_uci(r.pv[i]);
+                    }
+                    line += "\"}\n";
+                }
+                positions.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lk(outMutex);
+                out->write(line.data(), (std::streamsize)line.size());
+            }
+        });
+    }
+
+    // Stream lines straight from the mapping; blank and '#' lines are skipped
+    std::string_view data = input.view();
+    size_t lineNo = 0;
+    for (size_t pos = 0; pos < data.size();) {
+        size_t end = data.find('\n', pos);
+        if (end == std::string_view::npos) end = data.size();
+        std::string_view text = data.substr(pos, end - pos);
+        if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+        ++lineNo;
+        pos = end + 1;
+        if (text.empty() || text.front() == '#') continue;
+        queue.push(Job{lineNo, text});
+    }
+    queue.close();
+    for (auto& w : workers) w.join();
+    out->flush();
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    uint64_t nodes = totalNodes.load();
+    std::cerr << "analysed " << positions.load() << " positions with " << jobs << " jobs in "
+              << ms << " ms, " << nodes << " nodes, "
+              << nodes * 1000 / (uint64_t)std::max<int64_t>(1, ms) << " nps\n";
+    return 0;
+}
+
+} // namespace analyse
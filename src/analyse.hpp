@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace analyse {
+
+struct Options {
+    std::string epd;          // input: one EPD or FEN per line
+    std::string out = "-";    // JSONL output, "-" for stdout
+    int depth = 10;
+    int jobs = 0;             // 0 = one per hardware thread
+    size_t hashMB = 16;       // TT size per job
+    std::string syzygy;       // Syzygy tablebase directories, shared by the jobs
+};
+
+// FEN of an EPD or FEN line (move counters default to "0 1") and its id
+// opcode, if any. Returns false for lines that do not look like a position.
+bool parse_epd(std::string_view line, std::string& fen, std::string& id);
+
+// Parse "--epd F --depth D --jobs N --out F --hash MB --syzygy PATH"; false
+// on bad usage
+bool parse_args(int argc, char** argv, Options& opt);
+
+// Analyse every position of opt.epd with opt.jobs independent single-thread
+// searchers, each with its own TT, eval cache and pawn table. The input is
+// memory-mapped and handed out through a bounded queue, and one JSON object
+// per position is written as soon as it is done, so memory use does not
+// grow with the input. Output order follows completion; "line" gives the
+// input line number. Returns a process exit code.
+int run(const Options& opt);
+
+} // namespace analyse
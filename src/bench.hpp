@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+
+namespace nnue { class Network; }
+
+namespace bench {
+
+// Search the built-in position suite to `depth` with `threads` threads and a
+// `hashMB` table, starting every position from cleared tables. Prints per
+// position node counts, then total nodes, time, NPS and a signature derived
+// from every position's node count and best move; with one thread the
+// signature only changes when the search itself does. `net` selects NNUE
+// evaluation, null the classical eval.
+void run(int depth = 10, int threads = 1, size_t hashMB = 16, const nnue::Network* net = nullptr);
+
+} // namespace bench
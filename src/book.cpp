@@ -0,0 +1,85 @@
+#include "book.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace chess;
+
+namespace {
+
+constexpr size_t ENTRY_SIZE = 16;
+
+uint64_t read_be(const char* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v = (v << 8) | (uint8_t)p[i];
+    return v;
+}
+
+// Legal move of `b` for a Polyglot move: to file/rank in bits 0-5, from in
+// 6-11, promotion piece (1 = knight .. 4 = queen) in 12-14. Castling is
+// written king-takes-rook, as the chess library encodes it.
+Move decode(const Board& b, uint16_t pm) {
+    const int to = pm & 63, from = (pm >> 6) & 63, promo = (pm >> 12) & 7;
+    Movelist legal;
+    movegen::legalmoves(legal, b);
+    for (const Move& m : legal) {
+        if (m.from().index() != from || m.to().index() != to) continue;
+        if (m.typeOf() == Move::PROMOTION) {
+            if (promo == 1 + (int)m.promotionType() - (int)PieceType::KNIGHT) return m;
+        } else if (promo == 0) {
+            return m;
+        }
+    }
+    return Move::NO_MOVE;
+}
+
+} // namespace
+
+std::unique_ptr<Book> Book::open(const std::string& path, std::string& error) {
+    std::unique_ptr<Book> book(new Book(path));
+    if (!book->file_.ok()) {
+        error = "cannot read " + path;
+        return nullptr;
+    }
+    if (book->file_.view().size() % ENTRY_SIZE != 0) {
+        error = path + " is not a Polyglot book";
+        return nullptr;
+    }
+    book->entries_ = book->file_.view().size() / ENTRY_SIZE;
+    return book;
+}
+
+Move Book::probe(const Board& b, bool best) {
+    const char* data = file_.view().data();
+    const uint64_t key = b.hash();
+    auto keyAt = [&](size_t i) { return read_be(data + i * ENTRY_SIZE, 8); };
+
+    // First entry with this key
+    size_t lo = 0, hi = entries_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (keyAt(mid) < key) lo = mid + 1;
+        else hi = mid;
+    }
+
+    std::vector<std::pair<Move, uint32_t>> moves;
+    uint64_t total = 0;
+    for (size_t i = lo; i < entries_ && keyAt(i) == key; ++i) {
+        const char* e = data + i * ENTRY_SIZE;
+        Move m = decode(b, (uint16_t)read_be(e + 8, 2));
+        uint32_t weight = (uint32_t)read_be(e + 10, 2);
+        if (m == Move::NO_MOVE || weight == 0) continue;
+        moves.emplace_back(m, weight);
+        total += weight;
+    }
+    if (moves.empty()) return Move::NO_MOVE;
+
+    if (best)
+        return std::max_element(moves.begin(), moves.end(),
+                                [](const auto& x, const auto& y) { return x.second < y.second; })->first;
+    uint64_t pick = std::uniform_int_distribution<uint64_t>(0, total - 1)(rng_);
+    for (const auto& [m, weight] : moves) {
+        if (pick < weight) return m;
+        pick -= weight;
+    }
+    return moves.back().first;
+}
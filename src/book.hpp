@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include "external/chess/include/chess.hpp"
+#include "mapped_file.hpp"
+
+// Polyglot opening book. The file is a sorted array of 16-byte big-endian
+// entries (key, move, weight, learn), used in place from a memory mapping and
+// binary-searched by key. The chess library's Zobrist keys are Polyglot's, so
+// Board::hash() is the lookup key.
+class Book {
+public:
+    // Open `path`; on failure returns null and sets `error`
+    static std::unique_ptr<Book> open(const std::string& path, std::string& error);
+
+    const std::string& path() const { return path_; }
+
+    // A legal book move for `b`, or NO_MOVE: the highest weight if `best`,
+    // else drawn with probability proportional to weight
+    chess::Move probe(const chess::Board& b, bool best);
+
+private:
+    explicit Book(const std::string& path) : path_(path), file_(path, false), rng_(std::random_device{}()) {}
+
+    std::string path_;
+    MappedFile file_;
+    size_t entries_ = 0;
+    std::mt19937_64 rng_;
+};
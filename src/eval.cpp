@@ -1,80 +1,75 @@
 #include "eval.hpp"
 #include "pst.hpp"
 #include "external/chess/include/chess.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
 #include <cstdint>
-#include <mutex>
-#include <tuple>
-#include <unordered_map>
 #include <utility>
 
 using namespace chess;
 
 namespace {
 
-// Simple cache of evaluation results keyed by board hash
-std::unordered_map<uint64_t, int> eval_cache;
-std::mutex cache_mutex;
+// Piece-square tables and piece values reside in pst.cpp; the positional
+// terms below are (op, mg, eg) scores counted for White, negated for Black
+constexpr Score BISHOP_PAIR{30, 30, 35};
+constexpr Score KNIGHT_RIM{-20, -15, -10};
+constexpr Score ROOK_OPEN{20, 15, 10};
+constexpr Score ROOK_SEMI_OPEN{12, 10, 5};
+constexpr Score CONNECTED_ROOKS{12, 10, 10};
+constexpr Score TEMPO{8, 8, 8};
+constexpr Score DOUBLED_PAWN{-12, -10, -8};
+constexpr Score ISOLATED_PAWN{-10, -8, -6};
+// Passed pawn by relative rank (bonus increases toward promotion)
+constexpr Score PASSED_PAWN[8] = {{0, 0, 0},    {5, 5, 10},    {10, 10, 20},
+                                  {20, 20, 40}, {35, 35, 60},  {60, 60, 100},
+                                  {100, 100, 160}, {0, 0, 0}};
+// King shield, per adjacent file: pawn one rank further up / no pawn
+constexpr Score SHIELD_ADVANCED{-10, -8, -3};
+constexpr Score SHIELD_MISSING{-20, -15, -5};
 
-// Piece-square tables and piece values reside in pst.cpp
+// Phase contribution per piece type: N,B:1, R:2, Q:4
+constexpr int PHASE_WEIGHT[6] = {0, 1, 1, 2, 4, 0};
 
-inline int mirror(int idx) { return idx ^ 56; }
-
-} // namespace
-
-namespace eval {
-
-int evaluate(const Board &b) {
-  // Check cache first
-  uint64_t key = b.hash();
-  {
-    std::lock_guard<std::mutex> g(cache_mutex);
-    auto it = eval_cache.find(key);
-    if (it != eval_cache.end())
-      return it->second;
+// Zobrist keys for the pawn-only hash, [color][square]. The key of a
+// position starts from PAWN_KEY_BASE so that "no pawns" is not key 0, which
+// would match an empty pawn table entry.
+constexpr uint64_t splitmix64(uint64_t &state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+struct PawnKeys {
+  uint64_t key[2][64] = {};
+  constexpr PawnKeys() {
+    uint64_t state = 0x5EED5EED5EED5EEDULL;
+    for (auto &color : key)
+      for (auto &k : color)
+        k = splitmix64(state);
   }
+};
+constexpr PawnKeys PAWN_KEYS{};
+constexpr uint64_t PAWN_KEY_BASE = 0xA5A5A5A5A5A5A5A5ULL;
 
-  // Material + PST + bishop pair + simple pawn structure; tapered by game
-  // phase.
-  int op = 0, mg = 0, eg = 0;
+// Add (sign = 1) or remove (sign = -1) piece p on sq to the accumulator
+inline void add_piece(eval::Accumulator &acc, Piece p, int sq, int sign) {
+  int c = static_cast<int>(p.color());
+  int pt = static_cast<int>(p.type().internal());
+  acc.psq += pst::PSQ.score[c][pt][sq] * sign;
+  acc.phase += sign * PHASE_WEIGHT[pt];
+  if (pt == 0)
+    acc.pawnKey ^= PAWN_KEYS.key[c][sq];
+}
 
-  int phase = 0; // 0..24
-  // Phase weights: N,B:1, R:2, Q:4 (common approach)
-  auto count_phase = [&](PieceType pt, int per) {
-    int c =
-        b.pieces(pt, Color::WHITE).count() + b.pieces(pt, Color::BLACK).count();
-    phase += per * c;
-  };
-  count_phase(PieceType::KNIGHT, 1);
-  count_phase(PieceType::BISHOP, 1);
-  count_phase(PieceType::ROOK, 2);
-  count_phase(PieceType::QUEEN, 4);
-  if (phase > 24)
-    phase = 24;
-
-  // Tally material and PST using PESTO tables
-  for (int sq = 0; sq < 64; ++sq) {
-    Piece p = b.at(Square(sq));
-    if (p == Piece::NONE)
-      continue;
-    bool white = (p.color() == Color::WHITE);
-    int sign = white ? 1 : -1;
-
-    int pt = static_cast<int>(p.type().internal());
-    int idx = white ? sq : mirror(sq);
-    op += sign * (pst::OP_VALUE[pt] + pst::OP_PST[pt][idx]);
-    mg += sign * (pst::MG_VALUE[pt] + pst::MG_PST[pt][idx]);
-    eg += sign * (pst::EG_VALUE[pt] + pst::EG_PST[pt][idx]);
-  }
+// Pawn-only terms for the pawn hash entry: doubled, isolated and passed
+// pawns (white minus black), plus the passed-pawn and semi-open-file sets
+void evaluate_pawns(uint64_t whiteP, uint64_t blackP, eval::PawnEntry &e) {
+  e = eval::PawnEntry{};
+  Score score;
 
-  // Bishop pair
-  if (b.pieces(PieceType::BISHOP, Color::WHITE).count() >= 2)
-    op += 30, mg += 30, eg += 35;
-  if (b.pieces(PieceType::BISHOP, Color::BLACK).count() >= 2)
-    op -= 30, mg -= 30, eg -= 35;
-
-  // Pawn structure (very light): doubled & isolated
-  auto whiteP = b.pieces(PieceType::PAWN, Color::WHITE).getBits();
-  auto blackP = b.pieces(PieceType::PAWN, Color::BLACK).getBits();
+  // Doubled & isolated
   auto fileMask = [](int f) -> uint64_t { return 0x0101010101010101ULL << f; };
   int whiteDoubled = 0, blackDoubled = 0, whiteIso = 0, blackIso = 0;
   for (int f = 0; f < 8; ++f) {
@@ -87,22 +82,19 @@ int evaluate(const Board &b) {
 
     uint64_t left = (f > 0 ? fileMask(f - 1) : 0);
     uint64_t right = (f < 7 ? fileMask(f + 1) : 0);
+    if (!wf)
+      e.semiOpen[0] |= uint8_t(1 << f);
+    if (!bf)
+      e.semiOpen[1] |= uint8_t(1 << f);
     if (wf && ((whiteP & (left | right)) == 0))
       whiteIso += __builtin_popcountll(wf);
     if (bf && ((blackP & (left | right)) == 0))
       blackIso += __builtin_popcountll(bf);
   }
-  op += -12 * whiteDoubled + 12 * blackDoubled;
-  op += -10 * whiteIso + 10 * blackIso;
-  mg += -10 * whiteDoubled + 10 * blackDoubled;
-  mg += -8 * whiteIso + 8 * blackIso;
-  eg += -8 * whiteDoubled + 8 * blackDoubled;
-  eg += -6 * whiteIso + 6 * blackIso;
-
-  // Passed pawns (bonus increases toward promotion)
-  static const int PASS_OP[8] = {0, 5, 10, 20, 35, 60, 100, 0};
-  static const int PASS_MG[8] = {0, 5, 10, 20, 35, 60, 100, 0};
-  static const int PASS_EG[8] = {0, 10, 20, 40, 60, 100, 160, 0};
+  score += DOUBLED_PAWN * (whiteDoubled - blackDoubled);
+  score += ISOLATED_PAWN * (whiteIso - blackIso);
+
+  // Passed pawns
 
   auto passed_span_white = [&](int sq, int f) {
     uint64_t ahead = (~0ULL) << (sq + 8);
@@ -129,9 +121,8 @@ int evaluate(const Board &b) {
     int f = sq & 7;
     int r = sq >> 3;
     if ((blackP & passed_span_white(sq, f)) == 0) {
-      op += PASS_OP[r];
-      mg += PASS_MG[r];
-      eg += PASS_EG[r];
+      e.passed[0] |= 1ULL << sq;
+      score += PASSED_PAWN[r];
     }
     wp &= wp - 1;
   }
@@ -141,24 +132,269 @@ int evaluate(const Board &b) {
     int f = sq & 7;
     int r = 7 - (sq >> 3);
     if ((whiteP & passed_span_black(sq, f)) == 0) {
-      op -= PASS_OP[r];
-      mg -= PASS_MG[r];
-      eg -= PASS_EG[r];
+      e.passed[1] |= 1ULL << sq;
+      score -= PASSED_PAWN[r];
     }
     bp &= bp - 1;
   }
 
+  e.score = score;
+}
+
+// Pawn shield term (<= 0) for the king of color c on ksq
+Score king_shield(int ksq, Color c, uint64_t pawns) {
+  int file = ksq & 7;
+  int rank = ksq >> 3;
+  Score score;
+  int forward = (c == Color::WHITE) ? 1 : -1;
+  for (int df = -1; df <= 1; ++df) {
+    int f = file + df;
+    if (f < 0 || f > 7) {
+      score += SHIELD_MISSING;
+      continue;
+    }
+    int r1 = rank + forward;
+    int r2 = rank + 2 * forward;
+    bool shield1 = false, shield2 = false;
+    if (r1 >= 0 && r1 < 8) {
+      int sq1 = r1 * 8 + f;
+      shield1 = pawns & (1ULL << sq1);
+    }
+    if (!shield1 && r2 >= 0 && r2 < 8) {
+      int sq2 = r2 * 8 + f;
+      shield2 = pawns & (1ULL << sq2);
+    }
+    if (shield1)
+      continue;
+    score += shield2 ? SHIELD_ADVANCED : SHIELD_MISSING;
+  }
+  return score;
+}
+
+// Set-wise attack counting. A shift or occluded fill in one direction gives
+// each piece at most one target (sliders stop at the first blocker, which may
+// be another slider), and a piece's directions never overlap, so summing
+// popcounts over directions equals summing per-piece attack counts. The
+// four directions of a kind go through one 4-lane vector.
+typedef uint64_t U64x4 __attribute__((vector_size(32)));
+// Without AVX GCC notes that passing U64x4 by value has another ABI; these
+// helpers are internal and inlined, so that does not matter here
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+constexpr uint64_t NOT_A = ~FILE_A, NOT_H = ~(FILE_A << 7);
+constexpr uint64_t NOT_AB = ~(FILE_A | FILE_A << 1), NOT_GH = ~(FILE_A << 6 | FILE_A << 7);
+constexpr uint64_t CENTER = (1ULL << 27) | (1ULL << 28) | (1ULL << 35) | (1ULL << 36);
+
+// Slider directions: N, E, NE, NW shift left; S, W, SW, SE the same amounts right
+constexpr U64x4 SLIDE_SHIFT = {8, 1, 9, 7};
+constexpr U64x4 SLIDE_UP_MASK = {~0ULL, NOT_A, NOT_A, NOT_H};
+constexpr U64x4 SLIDE_DOWN_MASK = {~0ULL, NOT_H, NOT_H, NOT_A};
+// Knight jumps, likewise
+constexpr U64x4 KNIGHT_SHIFT = {17, 15, 10, 6};
+constexpr U64x4 KNIGHT_UP_MASK = {NOT_A, NOT_H, NOT_AB, NOT_GH};
+constexpr U64x4 KNIGHT_DOWN_MASK = {NOT_H, NOT_A, NOT_GH, NOT_AB};
+
+// Kogge-Stone occluded fill of each lane's sliders, then the attack step
+inline U64x4 slide_up(U64x4 gen, U64x4 empty) {
+  U64x4 pro = empty & SLIDE_UP_MASK;
+  gen |= pro & (gen << SLIDE_SHIFT);
+  pro &= pro << SLIDE_SHIFT;
+  gen |= pro & (gen << (SLIDE_SHIFT * 2));
+  pro &= pro << (SLIDE_SHIFT * 2);
+  gen |= pro & (gen << (SLIDE_SHIFT * 4));
+  return (gen << SLIDE_SHIFT) & SLIDE_UP_MASK;
+}
+inline U64x4 slide_down(U64x4 gen, U64x4 empty) {
+  U64x4 pro = empty & SLIDE_DOWN_MASK;
+  gen |= pro & (gen >> SLIDE_SHIFT);
+  pro &= pro >> SLIDE_SHIFT;
+  gen |= pro & (gen >> (SLIDE_SHIFT * 2));
+  pro &= pro >> (SLIDE_SHIFT * 2);
+  gen |= pro & (gen >> (SLIDE_SHIFT * 4));
+  return (gen >> SLIDE_SHIFT) & SLIDE_DOWN_MASK;
+}
+
+inline int popcount_masked(U64x4 v, uint64_t mask) {
+  return __builtin_popcountll(v[0] & mask) + __builtin_popcountll(v[1] & mask) +
+         __builtin_popcountll(v[2] & mask) + __builtin_popcountll(v[3] & mask);
+}
+
+// Weighted mobility plus center control of side c
+Score side_attacks(const Board &b, Color c) {
+  const uint64_t own = b.us(c).getBits();
+  const uint64_t empty = ~b.occ().getBits();
+  const uint64_t queens = b.pieces(PieceType::QUEEN, c).getBits();
+  const uint64_t orth = b.pieces(PieceType::ROOK, c).getBits() | queens;
+  const uint64_t diag = b.pieces(PieceType::BISHOP, c).getBits() | queens;
+  const uint64_t knights = b.pieces(PieceType::KNIGHT, c).getBits();
+  const uint64_t pawns = b.pieces(PieceType::PAWN, c).getBits();
+
+  const U64x4 sliders = {orth, orth, diag, diag};
+  const U64x4 empty4 = {empty, empty, empty, empty};
+  const U64x4 up = slide_up(sliders, empty4), down = slide_down(sliders, empty4);
+  const U64x4 knights4 = {knights, knights, knights, knights};
+  const U64x4 jumpsUp = (knights4 << KNIGHT_SHIFT) & KNIGHT_UP_MASK;
+  const U64x4 jumpsDown = (knights4 >> KNIGHT_SHIFT) & KNIGHT_DOWN_MASK;
+
+  const int mobility = popcount_masked(up, ~own) + popcount_masked(down, ~own) +
+                       popcount_masked(jumpsUp, ~own) +
+                       popcount_masked(jumpsDown, ~own);
+
+  const uint64_t pawnsWest = c == Color::WHITE ? (pawns << 7) & NOT_H : (pawns >> 9) & NOT_H;
+  const uint64_t pawnsEast = c == Color::WHITE ? (pawns << 9) & NOT_A : (pawns >> 7) & NOT_A;
+  const int center = popcount_masked(up, CENTER) + popcount_masked(down, CENTER) +
+                     popcount_masked(jumpsUp, CENTER) +
+                     popcount_masked(jumpsDown, CENTER) +
+                     __builtin_popcountll(pawnsWest & CENTER) +
+                     __builtin_popcountll(pawnsEast & CENTER) +
+                     __builtin_popcountll(attacks::king(b.kingSq(c)).getBits() & CENTER);
+
+  return pst::MOBILITY * mobility + pst::CENTER_CONTROL * center;
+}
+
+// Blend by game phase (24 = all pieces on, 0 = bare kings). The default
+// three-phase taper weights opening, middlegame and endgame by phase^2,
+// 2 phase (24 - phase) and (24 - phase)^2; -DMINERVA_TWO_PHASE_TAPER instead
+// interpolates linearly between middlegame and endgame, ignoring the opening.
+inline int taper(Score s, int phase) {
+#if defined(MINERVA_TWO_PHASE_TAPER)
+  return (s.mg() * phase + s.eg() * (24 - phase)) / 24;
+#else
+  int opWeight = phase * phase;
+  int mgWeight = 2 * phase * (24 - phase);
+  int egWeight = (24 - phase) * (24 - phase);
+  return (s.op() * opWeight + s.mg() * mgWeight + s.eg() * egWeight) /
+         (opWeight + mgWeight + egWeight);
+#endif
+}
+
+} // namespace
+
+namespace eval {
+
+void EvalCache::resize(size_t mb) {
+  size_t entries = std::max<size_t>(1, mb * 1024 * 1024 / sizeof(Entry));
+  entries = std::bit_floor(entries);
+  table_ = std::make_unique<Entry[]>(entries);
+  mask_ = entries - 1;
+}
+
+void EvalCache::clear() {
+  for (size_t i = 0; i <= mask_; ++i) {
+    table_[i].check.store(0, std::memory_order_relaxed);
+    table_[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+PawnTable::PawnTable() : table_(std::make_unique<PawnEntry[]>(SIZE)) {}
+
+void PawnTable::clear() {
+  for (size_t i = 0; i < SIZE; ++i)
+    table_[i] = PawnEntry{};
+  probes_ = hits_ = 0;
+}
+
+EvalCache &shared_cache() {
+  static EvalCache cache(0);
+  return cache;
+}
+
+Accumulator accumulate(const Board &b) {
+  Accumulator acc;
+  acc.pawnKey = PAWN_KEY_BASE;
+
+  // Tally material, PST and phase using PESTO tables
+  for (int sq = 0; sq < 64; ++sq) {
+    Piece p = b.at(Square(sq));
+    if (p == Piece::NONE)
+      continue;
+    add_piece(acc, p, sq, 1);
+  }
+  return acc;
+}
+
+void apply_move(Accumulator &acc, const Board &b, Move m) {
+  const int from = m.from().index();
+  const int to = m.to().index();
+  const Piece p = b.at(m.from());
+
+  if (m.typeOf() == Move::CASTLING) {
+    // Encoded as king takes own rook; destinations are the g/c and f/d files
+    const Piece rook = b.at(m.to());
+    const int rank = from & 56;
+    const bool kingSide = to > from;
+    add_piece(acc, p, from, -1);
+    add_piece(acc, rook, to, -1);
+    add_piece(acc, p, rank + (kingSide ? 6 : 2), 1);
+    add_piece(acc, rook, rank + (kingSide ? 5 : 3), 1);
+    return;
+  }
+
+  if (m.typeOf() == Move::ENPASSANT) {
+    const int capSq = m.to().ep_square().index();
+    add_piece(acc, b.at(Square(capSq)), capSq, -1);
+  } else {
+    const Piece captured = b.at(m.to());
+    if (captured != Piece::NONE)
+      add_piece(acc, captured, to, -1);
+  }
+
+  add_piece(acc, p, from, -1);
+  if (m.typeOf() == Move::PROMOTION)
+    add_piece(acc, Piece(m.promotionType(), p.color()), to, 1);
+  else
+    add_piece(acc, p, to, 1);
+}
+
+int evaluate(const Board &b, EvalCache *cache) {
+  return evaluate(b, accumulate(b), cache, nullptr);
+}
+
+int evaluate(const Board &b, const Accumulator &acc, EvalCache *cache,
+             PawnTable *pawns) {
+  // Check cache first
+  uint64_t key = b.hash();
+  int cached;
+  if (cache && cache->probe(key, cached))
+    return cached;
+
+  // Incrementally updated terms must match a full recompute
+  assert(acc == accumulate(b));
+
+  // Material + PST (from the accumulator) + bishop pair + simple pawn
+  // structure; tapered by game phase.
+  Score score = acc.psq;
+  int phase = std::min(acc.phase, 24); // 0..24
+
+  // Bishop pair
+  if (b.pieces(PieceType::BISHOP, Color::WHITE).count() >= 2)
+    score += BISHOP_PAIR;
+  if (b.pieces(PieceType::BISHOP, Color::BLACK).count() >= 2)
+    score -= BISHOP_PAIR;
+
+  // Pawn structure (doubled, isolated, passed) from the pawn hash table
+  auto whiteP = b.pieces(PieceType::PAWN, Color::WHITE).getBits();
+  auto blackP = b.pieces(PieceType::PAWN, Color::BLACK).getBits();
+  PawnEntry local;
+  PawnEntry &pe = pawns ? pawns->probe(acc.pawnKey) : local;
+  if (pe.key == acc.pawnKey) {
+    if (pawns)
+      pawns->hit();
+  } else {
+    evaluate_pawns(whiteP, blackP, pe);
+    pe.key = acc.pawnKey;
+  }
+  score += pe.score;
+
   // Knight on rim penalty ("A knight on the rim is dim")
   uint64_t wKnRim = b.pieces(PieceType::KNIGHT, Color::WHITE).getBits();
   while (wKnRim) {
     int sq = __builtin_ctzll(wKnRim);
     int f = sq & 7;
     int r = sq >> 3;
-    if (f == 0 || f == 7 || r == 0 || r == 7) {
-      op -= 20;
-      mg -= 15;
-      eg -= 10;
-    }
+    if (f == 0 || f == 7 || r == 0 || r == 7)
+      score += KNIGHT_RIM;
     wKnRim &= wKnRim - 1;
   }
   uint64_t bKnRim = b.pieces(PieceType::KNIGHT, Color::BLACK).getBits();
@@ -166,56 +402,32 @@ int evaluate(const Board &b) {
     int sq = __builtin_ctzll(bKnRim);
     int f = sq & 7;
     int r = sq >> 3;
-    if (f == 0 || f == 7 || r == 0 || r == 7) {
-      op += 20;
-      mg += 15;
-      eg += 10;
-    }
+    if (f == 0 || f == 7 || r == 0 || r == 7)
+      score -= KNIGHT_RIM;
     bKnRim &= bKnRim - 1;
   }
 
   // Rook placement: bonus for rooks on open/semi-open files
-  static const int ROOK_OPEN_OP = 20, ROOK_OPEN_MG = 15, ROOK_OPEN_EG = 10;
-  static const int ROOK_SEMI_OP = 12, ROOK_SEMI_MG = 10, ROOK_SEMI_EG = 5;
   uint64_t wr = b.pieces(PieceType::ROOK, Color::WHITE).getBits();
   while (wr) {
-    int sq = __builtin_ctzll(wr);
-    int f = sq & 7;
-    bool wpFile = whiteP & fileMask(f);
-    bool bpFile = blackP & fileMask(f);
-    if (!wpFile && !bpFile) {
-      op += ROOK_OPEN_OP;
-      mg += ROOK_OPEN_MG;
-      eg += ROOK_OPEN_EG;
-    } else if (!wpFile && bpFile) {
-      op += ROOK_SEMI_OP;
-      mg += ROOK_SEMI_MG;
-      eg += ROOK_SEMI_EG;
+    int f = __builtin_ctzll(wr) & 7;
+    if (pe.semiOpen[0] & (1 << f)) {
+      bool open = pe.semiOpen[1] & (1 << f);
+      score += open ? ROOK_OPEN : ROOK_SEMI_OPEN;
     }
     wr &= wr - 1;
   }
   uint64_t br = b.pieces(PieceType::ROOK, Color::BLACK).getBits();
   while (br) {
-    int sq = __builtin_ctzll(br);
-    int f = sq & 7;
-    bool bpFile = blackP & fileMask(f);
-    bool wpFile = whiteP & fileMask(f);
-    if (!bpFile && !wpFile) {
-      op -= ROOK_OPEN_OP;
-      mg -= ROOK_OPEN_MG;
-      eg -= ROOK_OPEN_EG;
-    } else if (!bpFile && wpFile) {
-      op -= ROOK_SEMI_OP;
-      mg -= ROOK_SEMI_MG;
-      eg -= ROOK_SEMI_EG;
+    int f = __builtin_ctzll(br) & 7;
+    if (pe.semiOpen[1] & (1 << f)) {
+      bool open = pe.semiOpen[0] & (1 << f);
+      score -= open ? ROOK_OPEN : ROOK_SEMI_OPEN;
     }
     br &= br - 1;
   }
 
   // Connected rooks bonus
-  constexpr int CONNECTED_R_OP = 12;
-  constexpr int CONNECTED_R_MG = 10;
-  constexpr int CONNECTED_R_EG = 10;
   auto connected_rooks = [&](Color c) {
     uint64_t r = b.pieces(PieceType::ROOK, c).getBits();
     if (__builtin_popcountll(r) < 2)
@@ -224,219 +436,43 @@ int evaluate(const Board &b) {
     r &= r - 1;
     int sq2 = __builtin_ctzll(r);
     uint64_t occ = b.occ().getBits();
-    if (attacks::rook(Square(sq1), occ).getBits() & (1ULL << sq2)) {
-      if (c == Color::WHITE) {
-        op += CONNECTED_R_OP;
-        mg += CONNECTED_R_MG;
-        eg += CONNECTED_R_EG;
-      } else {
-        op -= CONNECTED_R_OP;
-        mg -= CONNECTED_R_MG;
-        eg -= CONNECTED_R_EG;
-      }
-    }
+    if (attacks::rook(Square(sq1), occ).getBits() & (1ULL << sq2))
+      score += c == Color::WHITE ? CONNECTED_ROOKS : -CONNECTED_ROOKS;
   };
   connected_rooks(Color::WHITE);
   connected_rooks(Color::BLACK);
 
-  // King safety: penalize missing pawn shield
-  auto king_shield = [&](Color c) {
-    Square ksq = b.kingSq(c);
-    int file = ksq.file();
-    int rank = ksq.rank();
-    uint64_t pawns = b.pieces(PieceType::PAWN, c).getBits();
-    int penOp = 0, penMg = 0, penEg = 0;
-    int forward = (c == Color::WHITE) ? 1 : -1;
-    for (int df = -1; df <= 1; ++df) {
-      int f = file + df;
-      if (f < 0 || f > 7) {
-        penOp += 20;
-        penMg += 15;
-        penEg += 5;
-        continue;
-      }
-      int r1 = rank + forward;
-      int r2 = rank + 2 * forward;
-      bool shield1 = false, shield2 = false;
-      if (r1 >= 0 && r1 < 8) {
-        int sq1 = r1 * 8 + f;
-        shield1 = pawns & (1ULL << sq1);
-      }
-      if (!shield1 && r2 >= 0 && r2 < 8) {
-        int sq2 = r2 * 8 + f;
-        shield2 = pawns & (1ULL << sq2);
-      }
-      if (shield1)
-        continue;
-      if (shield2) {
-        penOp += 10;
-        penMg += 8;
-        penEg += 3;
-      } else {
-        penOp += 20;
-        penMg += 15;
-        penEg += 5;
-      }
+  // King safety: penalize missing pawn shield (cached per king square in the
+  // pawn entry)
+  for (int c = 0; c < 2; ++c) {
+    Color color = c == 0 ? Color::WHITE : Color::BLACK;
+    int ksq = b.kingSq(color).index();
+    if (pe.kingSq[c] != ksq) {
+      pe.shield[c] = king_shield(ksq, color, c == 0 ? whiteP : blackP);
+      pe.kingSq[c] = (int8_t)ksq;
     }
-    return std::tuple<int, int, int>{penOp, penMg, penEg};
-  };
-  auto [wksOp, wksMg, wksEg] = king_shield(Color::WHITE);
-  op -= wksOp;
-  mg -= wksMg;
-  eg -= wksEg;
-  auto [bksOp, bksMg, bksEg] = king_shield(Color::BLACK);
-  op += bksOp;
-  mg += bksMg;
-  eg += bksEg;
-
-  // Mobility (very simple: count of attacked squares for minor/major pieces)
-  auto wOcc = b.us(Color::WHITE).getBits();
-  auto bOcc2 = b.us(Color::BLACK).getBits();
-  int mobW = 0, mobB = 0;
-  auto occ = b.occ();
-  uint64_t wKn = b.pieces(PieceType::KNIGHT, Color::WHITE).getBits();
-  while (wKn) {
-    int sq = __builtin_ctzll(wKn);
-    mobW +=
-        __builtin_popcountll((attacks::knight(Square(sq)).getBits()) & ~wOcc);
-    wKn &= wKn - 1;
-  }
-  uint64_t bKn = b.pieces(PieceType::KNIGHT, Color::BLACK).getBits();
-  while (bKn) {
-    int sq = __builtin_ctzll(bKn);
-    mobB +=
-        __builtin_popcountll((attacks::knight(Square(sq)).getBits()) & ~bOcc2);
-    bKn &= bKn - 1;
-  }
-  uint64_t wBi = b.pieces(PieceType::BISHOP, Color::WHITE).getBits();
-  while (wBi) {
-    int sq = __builtin_ctzll(wBi);
-    mobW += __builtin_popcountll((attacks::bishop(Square(sq), occ).getBits()) &
-                                 ~wOcc);
-    wBi &= wBi - 1;
-  }
-  uint64_t bBi = b.pieces(PieceType::BISHOP, Color::BLACK).getBits();
-  while (bBi) {
-    int sq = __builtin_ctzll(bBi);
-    mobB += __builtin_popcountll((attacks::bishop(Square(sq), occ).getBits()) &
-                                 ~bOcc2);
-    bBi &= bBi - 1;
-  }
-  uint64_t wRk = b.pieces(PieceType::ROOK, Color::WHITE).getBits();
-  while (wRk) {
-    int sq = __builtin_ctzll(wRk);
-    mobW += __builtin_popcountll((attacks::rook(Square(sq), occ).getBits()) &
-                                 ~wOcc);
-    wRk &= wRk - 1;
-  }
-  uint64_t bRk = b.pieces(PieceType::ROOK, Color::BLACK).getBits();
-  while (bRk) {
-    int sq = __builtin_ctzll(bRk);
-    mobB += __builtin_popcountll((attacks::rook(Square(sq), occ).getBits()) &
-                                 ~bOcc2);
-    bRk &= bRk - 1;
-  }
-  uint64_t wQ = b.pieces(PieceType::QUEEN, Color::WHITE).getBits();
-  while (wQ) {
-    int sq = __builtin_ctzll(wQ);
-    mobW += __builtin_popcountll((attacks::queen(Square(sq), occ).getBits()) &
-                                 ~wOcc);
-    wQ &= wQ - 1;
   }
-  uint64_t bQ = b.pieces(PieceType::QUEEN, Color::BLACK).getBits();
-  while (bQ) {
-    int sq = __builtin_ctzll(bQ);
-    mobB += __builtin_popcountll((attacks::queen(Square(sq), occ).getBits()) &
-                                 ~bOcc2);
-    bQ &= bQ - 1;
-  }
-  op += 6 * (mobW - mobB);
-  mg += 4 * (mobW - mobB);
-  eg += 2 * (mobW - mobB);
-
-  // Center control: bonus for attacking the four central squares
-  const uint64_t CENTER =
-      (1ULL << 27) | (1ULL << 28) | (1ULL << 35) | (1ULL << 36);
-  auto count_center = [&](Color c) {
-    int total = 0;
-    uint64_t pieces;
-    pieces = b.pieces(PieceType::PAWN, c).getBits();
-    while (pieces) {
-      int sq = __builtin_ctzll(pieces);
-      total +=
-          __builtin_popcountll(attacks::pawn(c, Square(sq)).getBits() & CENTER);
-      pieces &= pieces - 1;
-    }
-    pieces = b.pieces(PieceType::KNIGHT, c).getBits();
-    while (pieces) {
-      int sq = __builtin_ctzll(pieces);
-      total +=
-          __builtin_popcountll(attacks::knight(Square(sq)).getBits() & CENTER);
-      pieces &= pieces - 1;
-    }
-    pieces = b.pieces(PieceType::BISHOP, c).getBits();
-    while (pieces) {
-      int sq = __builtin_ctzll(pieces);
-      total += __builtin_popcountll(attacks::bishop(Square(sq), occ).getBits() &
-                                    CENTER);
-      pieces &= pieces - 1;
-    }
-    pieces = b.pieces(PieceType::ROOK, c).getBits();
-    while (pieces) {
-      int sq = __builtin_ctzll(pieces);
-      total += __builtin_popcountll(attacks::rook(Square(sq), occ).getBits() &
-                                    CENTER);
-      pieces &= pieces - 1;
-    }
-    pieces = b.pieces(PieceType::QUEEN, c).getBits();
-    while (pieces) {
-      int sq = __builtin_ctzll(pieces);
-      total += __builtin_popcountll(attacks::queen(Square(sq), occ).getBits() &
-                                    CENTER);
-      pieces &= pieces - 1;
-    }
-    pieces = b.pieces(PieceType::KING, c).getBits();
-    while (pieces) {
-      int sq = __builtin_ctzll(pieces);
-      total +=
-          __builtin_popcountll(attacks::king(Square(sq)).getBits() & CENTER);
-      pieces &= pieces - 1;
-    }
-    return total;
-  };
-  int centerW = count_center(Color::WHITE);
-  int centerB = count_center(Color::BLACK);
-  op += 6 * (centerW - centerB);
-  mg += 4 * (centerW - centerB);
-  eg += 2 * (centerW - centerB);
+  score += pe.shield[0] - pe.shield[1];
+
+  // Mobility and center control, computed set-wise
+  score += mobility_and_center(b);
 
   // Tempo (small)
-  int tempo = (b.sideToMove() == Color::WHITE) ? 8 : -8;
+  score += b.sideToMove() == Color::WHITE ? TEMPO : -TEMPO;
 
-  int opScore = op + tempo;
-  int mgScore = mg + tempo;
-  int egScore = eg + tempo;
-
-  // Three-phase tapered scoring
-  int opWeight = phase * phase;
-  int mgWeight = 2 * phase * (24 - phase);
-  int egWeight = (24 - phase) * (24 - phase);
-  int totalWeight = opWeight + mgWeight + egWeight;
-  int score = (opScore * opWeight + mgScore * mgWeight + egScore * egWeight) /
-              totalWeight;
+  const int tapered = taper(score, phase);
 
   // Cache and return from side-to-move perspective
-  int finalScore = (b.sideToMove() == Color::WHITE) ? score : -score;
-  {
-    std::lock_guard<std::mutex> g(cache_mutex);
-    eval_cache[key] = finalScore;
-  }
+  int finalScore = (b.sideToMove() == Color::WHITE) ? tapered : -tapered;
+  if (cache)
+    cache->store(key, finalScore);
   return finalScore;
 }
 
-void clear_cache() {
-  std::lock_guard<std::mutex> g(cache_mutex);
-  eval_cache.clear();
+Score mobility_and_center(const Board &b) {
+  return side_attacks(b, Color::WHITE) - side_attacks(b, Color::BLACK);
 }
 
+void clear_cache() { shared_cache().clear(); }
+
 } // namespace eval
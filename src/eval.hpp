@@ -1,12 +1,114 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include "external/chess/include/chess.hpp"
+#include "score.hpp"
 
 namespace eval {
 
-// Evaluate from side-to-move perspective (centipawns)
-int evaluate(const chess::Board& b);
+// Fixed-size, power-of-two evaluation hash table. Entries are written without
+// locks: the key is stored XOR-ed with the data word, so an entry torn by a
+// concurrent writer simply fails verification and counts as a miss.
+class EvalCache {
+public:
+    explicit EvalCache(size_t mb = 16) { resize(mb); }
 
-// Clear any cached evaluation data (called on new game)
+    // Resize to the largest power-of-two entry count fitting in `mb` megabytes
+    // (at least one entry). Contents are cleared.
+    void resize(size_t mb);
+    void clear();
+
+    bool probe(uint64_t key, int& score) const {
+        const Entry& e = table_[key & mask_];
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        if ((e.check.load(std::memory_order_relaxed) ^ data) != key) return false;
+        score = (int32_t)(uint32_t)data;
+        return true;
+    }
+
+    void store(uint64_t key, int score) {
+        Entry& e = table_[key & mask_];
+        uint64_t data = (uint32_t)score;
+        e.check.store(key ^ data, std::memory_order_relaxed);
+        e.data.store(data, std::memory_order_relaxed);
+    }
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check{0}; // key ^ data
+        std::atomic<uint64_t> data{0};
+    };
+
+    std::unique_ptr<Entry[]> table_;
+    size_t mask_ = 0;
+};
+
+// Material + piece-square total (white minus black) and the raw game phase.
+// The search keeps one per ply and updates it from each move, so evaluate()
+// only has to add the positional terms.
+struct Accumulator {
+    Score psq;
+    int phase = 0; // N,B:1 R:2 Q:4; may exceed 24 after promotions
+    uint64_t pawnKey = 0; // Zobrist key of the pawn structure alone
+    bool operator==(const Accumulator&) const = default;
+};
+
+// Cached pawn-structure terms for one pawn configuration. The king shield is
+// pawn-dependent too and is cached for the king square it was computed for.
+struct PawnEntry {
+    uint64_t key = 0;
+    uint64_t passed[2] = {0, 0};     // passed pawns, [white, black]
+    Score score;                     // doubled/isolated/passed, white minus black
+    uint8_t semiOpen[2] = {0, 0};    // bit f set: no own pawn on file f
+    int8_t kingSq[2] = {-1, -1};     // squares `shield` was computed for
+    Score shield[2];                 // shield term (<= 0) per color, own view
+};
+
+// Per-thread pawn hash table, always-replace, with its own hit statistics
+class PawnTable {
+public:
+    static constexpr size_t SIZE = 1 << 14;
+
+    PawnTable();
+    void clear();
+
+    PawnEntry& probe(uint64_t key) {
+        probes_++;
+        return table_[key & (SIZE - 1)];
+    }
+    void hit() { hits_++; }
+
+    uint64_t probes() const { return probes_; }
+    uint64_t hits() const { return hits_; }
+    double hit_rate() const { return probes_ ? (double)hits_ / (double)probes_ : 0.0; }
+
+private:
+    std::unique_ptr<PawnEntry[]> table_;
+    uint64_t probes_ = 0, hits_ = 0;
+};
+
+// Full recompute from the board
+Accumulator accumulate(const chess::Board& b);
+
+// Update `acc` for move `m`; `b` is the position before the move is made
+void apply_move(Accumulator& acc, const chess::Board& b, chess::Move m);
+
+// Evaluate from side-to-move perspective (centipawns). If `cache` is given the
+// result is looked up in / stored to it; `pawns` caches the pawn terms.
+// Debug builds assert that `acc` matches accumulate(b).
+int evaluate(const chess::Board& b, const Accumulator& acc, EvalCache* cache,
+             PawnTable* pawns);
+int evaluate(const chess::Board& b, EvalCache* cache = nullptr);
+
+// Mobility and center-control term of evaluate(), white minus black
+Score mobility_and_center(const chess::Board& b);
+
+// Table used by all searchers when "EvalHashShared" is enabled
+EvalCache& shared_cache();
+
+// Clear the shared evaluation cache (called on new game)
 void clear_cache();
 
 } // namespace eval
@@ -1,6 +1,48 @@
 #include "uci.hpp"
+#include "analyse.hpp"
+#include "bench.hpp"
+#include "match.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    // minerva bench [depth] [threads] [hashMB]
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        int depth   = argc > 2 ? std::atoi(argv[2]) : 10;
+        int threads = argc > 3 ? std::atoi(argv[3]) : 1;
+        int hashMB  = argc > 4 ? std::atoi(argv[4]) : 16;
+        bench::run(depth, threads, (size_t)std::max(1, hashMB));
+        return 0;
+    }
+
+    // minerva analyse --epd in.epd [--depth D] [--jobs N] [--out out.jsonl] [--hash MB]
+    if (argc > 1 && std::string(argv[1]) == "analyse") {
+        analyse::Options opt;
+        if (!analyse::parse_args(argc, argv, opt)) {
+            std::cerr << "usage: minerva analyse --epd FILE [--depth D] [--jobs N]"
+                         " [--out FILE] [--hash MB]\n";
+            return 2;
+        }
+        return analyse::run(opt);
+    }
+
+    // minerva match [--engine1 F] [--engine2 F] [--games N] [--tc B+I | --nodes N | --depth D] ...
+    if (argc > 1 && std::string(argv[1]) == "match") {
+        match::Options opt;
+        if (!match::parse_args(argc, argv, opt)) {
+            std::cerr << "usage: minerva match [--engine1 FILE] [--engine2 FILE] [--games N]"
+                         " [--concurrency N] [--tc BASE+INC | --nodes N | --depth D]"
+                         " [--openings FILE] [--pgn FILE] [--hash MB] [--elo0 E] [--elo1 E]"
+                         " [--alpha A] [--beta B] [--draw-movenumber N] [--draw-movecount N]"
+                         " [--draw-score CP] [--resign-movecount N] [--resign-score CP]"
+                         " [--margin MS]\n";
+            return 2;
+        }
+        return match::run(opt);
+    }
 
-int main() {
     UciDriver uci;
     return uci.loop();
 }
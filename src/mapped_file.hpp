@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file: mmap where available, else read into
+// memory. `sequential` tells the kernel the mapping is read front to back;
+// otherwise it is read-ahead as a whole for random access.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path, bool sequential = true) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0) {
+            size_ = (size_t)st.st_size;
+            ok_ = true;
+            if (size_ > 0) {
+                void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    ::madvise(p, size_, sequential ? MADV_SEQUENTIAL : MADV_WILLNEED);
+                    data_ = (const char*)p;
+                    mapped_ = true;
+                } else {
+                    ok_ = false;
+                }
+            }
+        }
+        ::close(fd);
+        if (ok_) return;
+#endif
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return;
+        fallback_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+        ok_ = true;
+    }
+    ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapped_) ::munmap((void*)data_, size_);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool ok() const { return ok_; }
+    std::string_view view() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool ok_ = false;
+    bool mapped_ = false;
+    std::string fallback_;
+};
@@ -0,0 +1,766 @@
+#include "match.hpp"
+#include "analyse.hpp"
+#include "search.hpp"
+#include "tt.hpp"
+#include "uci.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace chess;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Balanced openings for when no --openings file is given, as moves from the
+// start position
+const char* const BUILTIN_OPENINGS[] = {
+    "e2e4 e7e5 g1f3 b8c6", "e2e4 c7c5 g1f3 d7d6", "e2e4 c7c5 b1c3 b8c6",
+    "e2e4 e7e6 d2d4 d7d5", "e2e4 c7c6 d2d4 d7d5", "e2e4 e7e5 f1c4 g8f6",
+    "e2e4 d7d6 d2d4 g8f6", "e2e4 g7g6 d2d4 f8g7", "d2d4 d7d5 c2c4 e7e6",
+    "d2d4 d7d5 c2c4 c7c6", "d2d4 g8f6 c2c4 e7e6", "d2d4 g8f6 c2c4 g7g6",
+    "d2d4 f7f5 g2g3 g8f6", "c2c4 e7e5 b1c3 g8f6", "c2c4 c7c5 g1f3 b8c6",
+    "g1f3 d7d5 g2g3 g8f6",
+};
+
+// A start position (empty fen = standard) plus forced opening moves
+struct Opening {
+    std::string fen;
+    std::vector<std::string> moves;
+};
+
+struct Reply {
+    Move move = Move::NO_MOVE;
+    bool hasScore = false;
+    int score = 0;      // side to move's view, mates as +-(MATE - ply)
+    bool timeout = false;
+};
+
+struct ClockState {
+    int time[2] = {0, 0}; // ms left, indexed by Color
+    int inc = 0;
+};
+
+// One side of a game; a worker owns two and reuses them for all its games
+class Engine {
+public:
+    virtual ~Engine() = default;
+    virtual const std::string& name() const = 0;
+    virtual void newGame() = 0;
+    // `position` is the UCI position command reaching `b`
+    virtual Reply go(const Board& b, const std::string& position, const ClockState& clock) = 0;
+};
+
+class InProcessEngine : public Engine {
+public:
+    InProcessEngine(const match::Options& opt, std::string name)
+        : opt_(opt), name_(std::move(name)), tt_(opt.hashMB), search_(std::make_unique<Search>(tt_)) {}
+
+    const std::string& name() const override { return name_; }
+
+    void newGame() override {
+        tt_.clear();
+        search_->newGame();
+    }
+
+    Reply go(const Board& b, const std::string&, const ClockState& clock) override {
+        SearchLimits lim;
+        lim.quiet = true;
+        lim.depth = opt_.depth;
+        lim.nodes = opt_.nodes;
+        if (opt_.timeMs > 0) {
+            const int us = (int)b.sideToMove();
+            auto budget = TimeManager::budget(clock.time[us], clock.inc, 0, 10);
+            lim.softMs = budget.optimum;
+            lim.timeMs = budget.maximum;
+        } else {
+            lim.timeMs = 24 * 60 * 60 * 1000;
+        }
+        tt_.new_generation();
+        SearchResult r = search_->go(b, lim);
+
+        Reply reply;
+        reply.move = r.best;
+        reply.hasScore = r.depth > 0;
+        reply.score = r.bestScore;
+        return reply;
+    }
+
+private:
+    const match::Options& opt_;
+    std::string name_;
+    TranspositionTable tt_;
+    std::unique_ptr<Search> search_;
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+// An engine binary spoken to over pipes
+class UciEngine : public Engine {
+public:
+    UciEngine(const match::Options& opt, const std::string& path) : opt_(opt), path_(path), name_(path) {
+        size_t slash = name_.find_last_of('/');
+        if (slash != std::string::npos) name_ = name_.substr(slash + 1);
+        spawn();
+    }
+
+    ~UciEngine() override { shutdown(); }
+
+    bool ok() const { return ok_; }
+    const std::string& name() const override { return name_; }
+
+    void newGame() override {
+        send("ucinewgame");
+        ready();
+    }
+
+    Reply go(const Board& b, const std::string& position, const ClockState& clock) override {
+        send(position);
+        std::string cmd = "go";
+        if (opt_.nodes) cmd += " nodes " + std::to_string(opt_.nodes);
+        if (opt_.depth) cmd += " depth " + std::to_string(opt_.depth);
+        if (opt_.timeMs > 0) {
+            cmd += " wtime " + std::to_string(clock.time[0]) + " btime " + std::to_string(clock.time[1]);
+            if (clock.inc) cmd += " winc " + std::to_string(clock.inc) + " binc " + std::to_string(clock.inc);
+        }
+        send(cmd);
+
+        // Clock games get their time plus the margin; fixed nodes/depth
+        // searches are only cut off if the engine hangs
+        const int us = (int)b.sideToMove();
+        const int limit = opt_.timeMs > 0 ? clock.time[us] + opt_.marginMs + 1000 : 300000;
+        auto deadline = Clock::now() + std::chrono::milliseconds(limit);
+
+        Reply reply;
+        std::string line;
+        while (true) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left <= 0 || !readLine(line, (int)left)) {
+                reply.timeout = true;
+                abandonSearch();
+                return reply;
+            }
+            std::istringstream is(line);
+            std::string tok;
+            is >> tok;
+            if (tok == "info") {
+                bool mainLine = true;
+                while (is >> tok) {
+                    if (tok == "multipv") {
+                        int n = 1;
+                        is >> n;
+                        mainLine = n == 1;
+                    } else if (tok == "score" && mainLine) {
+                        std::string kind;
+                        int v = 0;
+                        is >> kind >> v;
+                        if (kind == "cp") {
+                            reply.hasScore = true;
+                            reply.score = v;
+                        } else if (kind == "mate") {
+                            reply.hasScore = true;
+                            reply.score = v > 0 ? ::utils::MATE - (2 * v - 1) : -::utils::MATE - 2 * v;
+                        }
+                    } else if (tok == "pv") {
+                        break;
+                    }
+                }
+            } else if (tok == "bestmove") {
+                is >> tok;
+                reply.move = UciDriver::uci_to_move(b, tok);
+                return reply;
+            }
+        }
+    }
+
+private:
+    // Start the child and bring it up to isready; sets ok_
+    void spawn() {
+        ok_ = false;
+        buf_.clear();
+        int toChild[2], fromChild[2];
+        if (::pipe(toChild) != 0) return;
+        if (::pipe(fromChild) != 0) {
+            ::close(toChild[0]); ::close(toChild[1]);
+            return;
+        }
+        pid_ = ::fork();
+        if (pid_ == 0) {
+            ::dup2(toChild[0], STDIN_FILENO);
+            ::dup2(fromChild[1], STDOUT_FILENO);
+            ::close(toChild[0]); ::close(toChild[1]);
+            ::close(fromChild[0]); ::close(fromChild[1]);
+            ::execl(path_.c_str(), path_.c_str(), (char*)nullptr);
+            ::_exit(127);
+        }
+        ::close(toChild[0]);
+        ::close(fromChild[1]);
+        if (pid_ < 0) {
+            ::close(toChild[1]); ::close(fromChild[0]);
+            return;
+        }
+        in_ = toChild[1];
+        out_ = fromChild[0];
+
+        std::string line;
+        send("uci");
+        while (readLine(line, 10000)) {
+            if (line.rfind("id name ", 0) == 0) name_ = line.substr(8);
+            if (line == "uciok") {
+                ok_ = true;
+                break;
+            }
+        }
+        if (!ok_) return;
+        send("setoption name Hash value " + std::to_string(opt_.hashMB));
+        ok_ = ready();
+    }
+
+    // Quit the child, killing it if it does not exit by itself
+    void shutdown() {
+        if (in_ >= 0) {
+            send("quit");
+            ::close(in_);
+            in_ = -1;
+        }
+        if (out_ >= 0) ::close(out_);
+        out_ = -1;
+        if (pid_ > 0) {
+            // Give it a moment to exit by itself
+            bool exited = false;
+            for (int i = 0; i < 100 && !exited; ++i) {
+                exited = ::waitpid(pid_, nullptr, WNOHANG) == pid_;
+                if (!exited) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if (!exited) {
+                ::kill(pid_, SIGKILL);
+                ::waitpid(pid_, nullptr, 0);
+            }
+        }
+        pid_ = -1;
+    }
+
+    // After a timeout the child is still searching, and its late bestmove
+    // would answer the next go. Stop it and read that bestmove; a child that
+    // does not answer within a second is restarted.
+    void abandonSearch() {
+        send("stop");
+        std::string line;
+        auto deadline = Clock::now() + std::chrono::milliseconds(1000);
+        while (true) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left <= 0 || !readLine(line, (int)left)) break;
+            if (line.rfind("bestmove", 0) == 0) return;
+        }
+        shutdown();
+        spawn();
+    }
+
+    void send(const std::string& s) {
+        std::string msg = s + "\n";
+        size_t done = 0;
+        while (done < msg.size()) {
+            ssize_t n = ::write(in_, msg.data() + done, msg.size() - done);
+            if (n <= 0) return;
+            done += (size_t)n;
+        }
+    }
+
+    // Next output line, waiting at most timeoutMs; false on timeout or EOF
+    bool readLine(std::string& line, int timeoutMs) {
+        if (out_ < 0) return false; // no child (a restart failed)
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            size_t nl = buf_.find('\n');
+            if (nl != std::string::npos) {
+                line = buf_.substr(0, nl);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                buf_.erase(0, nl + 1);
+                return true;
+            }
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left <= 0) return false;
+            pollfd pfd{out_, POLLIN, 0};
+            if (::poll(&pfd, 1, (int)left) <= 0) return false;
+            char chunk[4096];
+            ssize_t n = ::read(out_, chunk, sizeof(chunk));
+            if (n <= 0) return false;
+            buf_.append(chunk, (size_t)n);
+        }
+    }
+
+    bool ready() {
+        send("isready");
+        std::string line;
+        while (readLine(line, 10000))
+            if (line == "readyok") return true;
+        return false;
+    }
+
+    const match::Options& opt_;
+    std::string path_;
+    std::string name_;
+    pid_t pid_ = -1;
+    int in_ = -1, out_ = -1;
+    std::string buf_;
+    bool ok_ = false;
+};
+#endif
+
+std::unique_ptr<Engine> make_engine(const match::Options& opt, const std::string& path, const std::string& name) {
+    if (path.empty()) return std::make_unique<InProcessEngine>(opt, name);
+#if defined(__unix__) || defined(__APPLE__)
+    auto e = std::make_unique<UciEngine>(opt, path);
+    if (e->ok()) return e;
+#endif
+    return nullptr;
+}
+
+char piece_letter(PieceType pt) {
+    if (pt == PieceType::KNIGHT) return 'N';
+    if (pt == PieceType::BISHOP) return 'B';
+    if (pt == PieceType::ROOK) return 'R';
+    if (pt == PieceType::QUEEN) return 'Q';
+    return 'K';
+}
+
+void append_square(std::string& s, Square sq) {
+    s += char('a' + sq.file());
+    s += char('1' + sq.rank());
+}
+
+// Standard algebraic notation of legal move m in b
+std::string to_san(const Board& b, const Move& m) {
+    std::string s;
+    if (m.typeOf() == Move::CASTLING) {
+        s = m.to().index() > m.from().index() ? "O-O" : "O-O-O";
+    } else {
+        const PieceType pt = b.at<PieceType>(m.from());
+        const bool capture = b.isCapture(m);
+        if (pt == PieceType::PAWN) {
+            if (capture) {
+                s += char('a' + m.from().file());
+                s += 'x';
+            }
+        } else {
+            s += piece_letter(pt);
+            // Disambiguate by file, else rank, else both
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            Movelist ml;
+            movegen::legalmoves(ml, b);
+            for (const auto& o : ml) {
+                if (o.to() != m.to() || o.from() == m.from() || o.typeOf() == Move::CASTLING) continue;
+                if (b.at<PieceType>(o.from()) != pt) continue;
+                ambiguous = true;
+                sameFile |= o.from().file() == m.from().file();
+                sameRank |= o.from().rank() == m.from().rank();
+            }
+            if (ambiguous) {
+                if (!sameFile) s += char('a' + m.from().file());
+                else if (!sameRank) s += char('1' + m.from().rank());
+                else append_square(s, m.from());
+            }
+            if (capture) s += 'x';
+        }
+        append_square(s, m.to());
+        if (m.typeOf() == Move::PROMOTION) {
+            s += '=';
+            s += piece_letter(m.promotionType());
+        }
+    }
+
+    Board after = b;
+    after.makeMove(m);
+    if (after.inCheck()) {
+        Movelist replies;
+        movegen::legalmoves(replies, after);
+        s += replies.empty() ? '#' : '+';
+    }
+    return s;
+}
+
+struct GameRecord {
+    std::string fen;              // empty = standard start
+    int firstMoveNumber = 1;
+    bool blackFirst = false;
+    std::vector<std::string> san;
+    std::string result = "*";     // White's view
+    std::string termination;
+};
+
+// Play one game; engines are indexed by colour
+GameRecord play_game(const match::Options& opt, Engine* engines[2], const Opening& opening) {
+    GameRecord g;
+    g.fen = opening.fen;
+    Board b = opening.fen.empty() ? Board() : Board(opening.fen);
+    g.firstMoveNumber = b.fullMoveNumber();
+    g.blackFirst = b.sideToMove() == Color::BLACK;
+
+    std::string position = opening.fen.empty() ? "position startpos" : "position fen " + opening.fen;
+    std::string moves;
+    auto push = [&](const Move& m) {
+        g.san.push_back(to_san(b, m));
+        moves += (moves.empty() ? " moves " : " ") + UciDriver::move_to_uci(m);
+        b.makeMove(m);
+    };
+    for (const auto& u : opening.moves) push(UciDriver::uci_to_move(b, u));
+
+    engines[0]->newGame();
+    engines[1]->newGame();
+
+    ClockState clock;
+    clock.time[0] = clock.time[1] = opt.timeMs;
+    clock.inc = opt.incMs;
+
+    auto finish = [&](const char* result, const char* termination) {
+        g.result = result;
+        g.termination = termination;
+        return g;
+    };
+    auto win = [&](Color c, const char* termination) {
+        return finish(c == Color::WHITE ? "1-0" : "0-1", termination);
+    };
+
+    int drawPlies = 0, whiteUpPlies = 0, blackUpPlies = 0;
+    for (int ply = 0; ply < 1000; ++ply) {
+        Movelist ml;
+        movegen::legalmoves(ml, b);
+        const Color us = b.sideToMove();
+        if (ml.empty()) return b.inCheck() ? win(~us, "checkmate") : finish("1/2-1/2", "stalemate");
+        if (b.isInsufficientMaterial()) return finish("1/2-1/2", "insufficient material");
+        if (b.isHalfMoveDraw()) return finish("1/2-1/2", "fifty-move rule");
+        if (b.isRepetition(2)) return finish("1/2-1/2", "threefold repetition");
+
+        auto t0 = Clock::now();
+        Reply r = engines[(int)us]->go(b, position + moves, clock);
+        int spent = (int)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count();
+
+        if (r.timeout) return win(~us, "time forfeit");
+        if (opt.timeMs > 0) {
+            if (spent > clock.time[(int)us] + opt.marginMs) return win(~us, "time forfeit");
+            clock.time[(int)us] = std::max(0, clock.time[(int)us] - spent) + clock.inc;
+        }
+        bool legal = false;
+        for (const auto& m : ml) legal |= m == r.move;
+        if (!legal) return win(~us, "illegal move");
+
+        if (r.hasScore) {
+            const int white = us == Color::WHITE ? r.score : -r.score;
+            drawPlies = std::abs(white) <= opt.drawScore ? drawPlies + 1 : 0;
+            whiteUpPlies = white >= opt.resignScore ? whiteUpPlies + 1 : 0;
+            blackUpPlies = -white >= opt.resignScore ? blackUpPlies + 1 : 0;
+        } else {
+            drawPlies = whiteUpPlies = blackUpPlies = 0;
+        }
+        push(r.move);
+
+        if (opt.resignMoveCount > 0) {
+            if (whiteUpPlies >= 2 * opt.resignMoveCount) return win(Color::WHITE, "adjudication");
+            if (blackUpPlies >= 2 * opt.resignMoveCount) return win(Color::BLACK, "adjudication");
+        }
+        if (opt.drawMoveCount > 0 && b.fullMoveNumber() >= opt.drawMoveNumber
+            && drawPlies >= 2 * opt.drawMoveCount)
+            return finish("1/2-1/2", "adjudication");
+    }
+    return finish("1/2-1/2", "move limit");
+}
+
+// The same text python-chess prints for Game.from_board() with game.py's
+// headers added: seven-tag roster, SetUp/FEN for set-up positions, then
+// movetext wrapped at 80 columns
+std::string to_pgn(const GameRecord& g, const std::string& white, const std::string& black,
+                   const std::string& date, int round) {
+    std::string s;
+    auto header = [&](const char* key, const std::string& value) {
+        s += '[';
+        s += key;
+        s += " \"" + value + "\"]\n";
+    };
+    header("Event", "Minerva Match");
+    header("Site", "Local");
+    header("Date", date);
+    header("Round", std::to_string(round));
+    header("White", white);
+    header("Black", black);
+    header("Result", g.result);
+    if (!g.fen.empty()) {
+        header("SetUp", "1");
+        header("FEN", g.fen);
+    }
+    header("Termination", g.termination);
+    s += '\n';
+
+    std::string line;
+    auto emit = [&](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() > 80) {
+            s += line + '\n';
+            line.clear();
+        }
+        if (!line.empty()) line += ' ';
+        line += token;
+    };
+    int number = g.firstMoveNumber;
+    for (size_t i = 0; i < g.san.size(); ++i) {
+        bool black = (i % 2 == 0) == g.blackFirst;
+        if (!black) emit(std::to_string(number) + ". " + g.san[i]);
+        else if (i == 0) emit(std::to_string(number) + "... " + g.san[i]);
+        else emit(g.san[i]);
+        if (black) ++number;
+    }
+    emit(g.result);
+    s += line + "\n\n";
+    return s;
+}
+
+double logistic(double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+double elo_of(double score) {
+    score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// Pair scores 0, 1/2, 1, 3/2, 2 for engine1; mean and variance of a pair's
+// per-game score
+void pair_stats(const std::array<int, 5>& penta, int& pairs, double& mean, double& var) {
+    pairs = 0;
+    double sum = 0.0;
+    for (int i = 0; i < 5; ++i) {
+        pairs += penta[i];
+        sum += penta[i] * (i / 4.0);
+    }
+    mean = pairs ? sum / pairs : 0.5;
+    var = 0.0;
+    for (int i = 0; i < 5; ++i) var += penta[i] * (i / 4.0 - mean) * (i / 4.0 - mean);
+    var = pairs ? var / pairs : 0.0;
+}
+
+// Normal approximation of the pentanomial GSPRT log-likelihood ratio
+double llr(const std::array<int, 5>& penta, double elo0, double elo1) {
+    int pairs;
+    double mean, var;
+    pair_stats(penta, pairs, mean, var);
+    if (pairs == 0 || var <= 0.0) return 0.0;
+    const double s0 = logistic(elo0), s1 = logistic(elo1);
+    return pairs * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * var);
+}
+
+bool parse_tc(const std::string& v, int& timeMs, int& incMs) {
+    size_t plus = v.find('+');
+    timeMs = (int)std::lround(std::stod(v.substr(0, plus)) * 1000.0);
+    incMs = plus == std::string::npos ? 0 : (int)std::lround(std::stod(v.substr(plus + 1)) * 1000.0);
+    return timeMs > 0 && incMs >= 0;
+}
+
+// Openings from an EPD/FEN file, or the built-in move sequences
+bool load_openings(const std::string& path, std::vector<Opening>& out) {
+    if (path.empty()) {
+        for (const char* line : BUILTIN_OPENINGS) {
+            Opening o;
+            std::istringstream is(line);
+            std::string u;
+            Board b;
+            bool ok = true;
+            while (ok && is >> u) {
+                Move m = UciDriver::uci_to_move(b, u);
+                ok = m != Move::NO_MOVE;
+                if (ok) b.makeMove(m);
+                o.moves.push_back(u);
+            }
+            if (ok) out.push_back(std::move(o));
+        }
+        return !out.empty();
+    }
+
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line, fen, id;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line.front() == '#') continue;
+        if (analyse::parse_epd(line, fen, id)) out.push_back(Opening{fen, {}});
+    }
+    return !out.empty();
+}
+
+} // namespace
+
+namespace match {
+
+bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) return false;
+        std::string v = argv[++i];
+        try {
+            if (a == "--engine1") opt.engine1 = v;
+            else if (a == "--engine2") opt.engine2 = v;
+            else if (a == "--openings") opt.openings = v;
+            else if (a == "--pgn") opt.pgn = v;
+            else if (a == "--games") opt.games = std::stoi(v);
+            else if (a == "--concurrency") opt.concurrency = std::stoi(v);
+            else if (a == "--nodes") opt.nodes = std::stoull(v);
+            else if (a == "--depth") opt.depth = std::stoi(v);
+            else if (a == "--tc") { if (!parse_tc(v, opt.timeMs, opt.incMs)) return false; }
+            else if (a == "--margin") opt.marginMs = std::stoi(v);
+            else if (a == "--hash") opt.hashMB = (size_t)std::max(1, std::stoi(v));
+            else if (a == "--draw-movenumber") opt.drawMoveNumber = std::stoi(v);
+            else if (a == "--draw-movecount") opt.drawMoveCount = std::stoi(v);
+            else if (a == "--draw-score") opt.drawScore = std::stoi(v);
+            else if (a == "--resign-movecount") opt.resignMoveCount = std::stoi(v);
+            else if (a == "--resign-score") opt.resignScore = std::stoi(v);
+            else if (a == "--elo0") opt.elo0 = std::stod(v);
+            else if (a == "--elo1") opt.elo1 = std::stod(v);
+            else if (a == "--alpha") opt.alpha = std::stod(v);
+            else if (a == "--beta") opt.beta = std::stod(v);
+            else return false;
+        } catch (...) {
+            return false;
+        }
+    }
+    return opt.games > 0 && opt.alpha > 0 && opt.alpha < 1 && opt.beta > 0 && opt.beta < 1;
+}
+
+int run(const Options& options) {
+    Options opt = options;
+    if (!opt.nodes && !opt.depth && opt.timeMs <= 0) {
+        opt.timeMs = 10000;
+        opt.incMs = 100;
+    }
+
+    std::vector<Opening> openings;
+    if (!load_openings(opt.openings, openings)) {
+        std::cerr << "match: no openings in " << opt.openings << "\n";
+        return 1;
+    }
+
+    std::ofstream pgn;
+    if (!opt.pgn.empty()) {
+        pgn.open(opt.pgn, std::ios::binary | std::ios::app);
+        if (!pgn) {
+            std::cerr << "match: cannot write " << opt.pgn << "\n";
+            return 1;
+        }
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // A child that dies must not take the whole match with it
+    if (!opt.engine1.empty() || !opt.engine2.empty()) std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    const int pairs = (opt.games + 1) / 2;
+    const int concurrency = std::clamp(
+        opt.concurrency > 0 ? opt.concurrency : (int)std::thread::hardware_concurrency(), 1, pairs);
+    const double lower = std::log(opt.beta / (1.0 - opt.alpha));
+    const double upper = std::log((1.0 - opt.beta) / opt.alpha);
+
+    char date[16];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+
+    std::mutex mutex; // results, output and engine start-up failures
+    std::atomic<int> nextPair{0};
+    std::atomic<bool> finished{false};
+    int wins = 0, losses = 0, draws = 0;
+    std::array<int, 5> penta{};
+    bool failed = false;
+    std::string names[2];
+
+    auto worker = [&] {
+        std::unique_ptr<Engine> a = make_engine(opt, opt.engine1, "Minerva");
+        std::unique_ptr<Engine> b = make_engine(opt, opt.engine2, "Minerva");
+        if (!a || !b) {
+            std::lock_guard<std::mutex> lk(mutex);
+            if (!failed) std::cerr << "match: cannot start " << (a ? opt.engine2 : opt.engine1) << "\n";
+            failed = true;
+            finished = true;
+            return;
+        }
+        std::string white = a->name(), black = b->name();
+        if (white == black) {
+            white += "-1";
+            black += "-2";
+        }
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            names[0] = white;
+            names[1] = black;
+        }
+
+        while (!finished) {
+            const int p = nextPair.fetch_add(1);
+            if (p >= pairs) break;
+            const Opening& opening = openings[(size_t)p % openings.size()];
+
+            Engine* first[2] = {a.get(), b.get()};
+            Engine* second[2] = {b.get(), a.get()};
+            GameRecord g1 = play_game(opt, first, opening);
+            GameRecord g2 = play_game(opt, second, opening);
+
+            // engine1's points, in half points
+            auto points = [](const std::string& result, bool engine1White) {
+                if (result == "1/2-1/2") return 1;
+                return (result == "1-0") == engine1White ? 2 : 0;
+            };
+            const int p1 = points(g1.result, true), p2 = points(g2.result, false);
+
+            std::lock_guard<std::mutex> lk(mutex);
+            for (int pts : {p1, p2}) {
+                if (pts == 2) ++wins;
+                else if (pts == 0) ++losses;
+                else ++draws;
+            }
+            ++penta[(p1 + p2)];
+            if (pgn) {
+                pgn << to_pgn(g1, white, black, date, 2 * p + 1) << to_pgn(g2, black, white, date, 2 * p + 2);
+                pgn.flush();
+            }
+
+            int n;
+            double mean, var;
+            pair_stats(penta, n, mean, var);
+            const double se = std::sqrt(var / n);
+            const double elo = elo_of(mean);
+            const double err = (elo_of(mean + 1.96 * se) - elo_of(mean - 1.96 * se)) / 2.0;
+            const double ratio = llr(penta, opt.elo0, opt.elo1);
+            char buf[256];
+            std::snprintf(buf, sizeof(buf),
+                          "Games %d: +%d -%d =%d  Elo %.1f +/- %.1f  LLR %.2f (%.2f, %.2f) [%.1f, %.1f]"
+                          "  Ptnml(0-2) %d %d %d %d %d\n",
+                          wins + losses + draws, wins, losses, draws, elo, err, ratio, lower, upper,
+                          opt.elo0, opt.elo1, penta[0], penta[1], penta[2], penta[3], penta[4]);
+            std::cout << buf << std::flush;
+            if (ratio <= lower || ratio >= upper) finished = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < concurrency; ++i) threads.emplace_back(worker);
+    for (auto& t : threads) t.join();
+    if (failed) return 1;
+
+    const double ratio = llr(penta, opt.elo0, opt.elo1);
+    std::cout << "Score of " << names[0] << " vs " << names[1] << ": " << wins << " - " << losses
+              << " - " << draws << "\nSPRT: "
+              << (ratio >= upper ? "H1 accepted" : ratio <= lower ? "H0 accepted" : "inconclusive")
+              << "\n";
+    return 0;
+}
+
+} // namespace match
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace match {
+
+struct Options {
+    std::string engine1, engine2; // UCI executables; empty = this engine, in-process
+    std::string openings;         // EPD/FEN file; empty = built-in move sequences
+    std::string pgn;              // PGN output file; empty = none
+    int games = 100;              // upper bound, rounded up to whole pairs
+    int concurrency = 0;          // games in flight, 0 = one per hardware thread
+    uint64_t nodes = 0;           // per move; with depth and timeMs all 0, 10+0.1 is used
+    int depth = 0;
+    int timeMs = 0, incMs = 0;    // clock per side: --tc 10+0.1 (seconds)
+    int marginMs = 50;            // allowed clock overrun before a time forfeit
+    size_t hashMB = 16;           // TT per engine instance
+
+    // Adjudication; a move count of 0 disables the rule. Draw once both
+    // sides have reported |score| <= drawScore for drawMoveCount moves each,
+    // from move drawMoveNumber on; resign once both agree one side is up
+    // resignScore or more for resignMoveCount moves each.
+    int drawMoveNumber = 40, drawMoveCount = 8, drawScore = 10;
+    int resignMoveCount = 3, resignScore = 1000;
+
+    // SPRT of H0: elo = elo0 against H1: elo = elo1 (logistic), from engine1's side
+    double elo0 = 0.0, elo1 = 5.0, alpha = 0.05, beta = 0.05;
+};
+
+// Parse "--engine1 F --engine2 F --games N --concurrency N --nodes N
+// --depth D --tc B+I --openings F --pgn F --hash MB ..."; false on bad usage
+bool parse_args(int argc, char** argv, Options& opt);
+
+// Play engine1 against engine2 in pairs of games from the same opening with
+// colours swapped, opt.concurrency pairs at a time. A status line with the
+// score, Elo, pentanomial pair counts and the SPRT log-likelihood ratio is
+// printed after every pair, and the match ends early once the LLR leaves
+// its bounds. Games are appended to opt.pgn in the format game.py's
+// save_pgn() writes. Returns a process exit code.
+int run(const Options& opt);
+
+} // namespace match
@@ -0,0 +1,214 @@
+#include "microbench.hpp"
+#include "eval.hpp"
+#include "move_order.hpp"
+#include "pst.hpp"
+#include "see.hpp"
+#include "tt.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace chess;
+
+namespace {
+
+// Middlegame positions with plenty of exchanges on the board
+const char* const POSITIONS[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r2q1rk1/pp2bppp/2n1pn2/2pp4/3P4/2PBPN2/PP1N1PPP/R2QK2R w KQ - 0 9",
+    "2r2rk1/1bqnbppp/p2ppn2/1p6/3NP3/1BN1BP2/PPPQ2PP/2KR3R w - - 0 14",
+    "r1b2rk1/2q1bppp/p2ppn2/1p6/3BPP2/2NB4/PPPQ2PP/2KR3R w - - 0 13",
+    "3r1rk1/p1q2ppp/1pn1pn2/2b5/2P5/P1N1BN2/1PQ2PPP/3R1RK1 b - - 0 16",
+};
+
+using Clock = std::chrono::steady_clock;
+
+// ns per call of `calls` calls made by one run of `f`: the best of
+// microbench::REPEATS runs after a warm-up, which discards runs slowed by
+// interrupts, frequency changes or a cold cache
+template <class F>
+double ns_per_call(uint64_t calls, F&& f) {
+    f();
+    double best = 0;
+    for (int i = 0; i < microbench::REPEATS; ++i) {
+        auto t0 = Clock::now();
+        f();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        if (i == 0 || ns < best) best = ns;
+    }
+    return best / (double)calls;
+}
+
+// The mobility/center terms as evaluate() used to compute them, piece by
+// piece, for comparison with eval::mobility_and_center()
+Score mobility_and_center_per_piece(const Board& b) {
+    constexpr uint64_t CENTER = (1ULL << 27) | (1ULL << 28) | (1ULL << 35) | (1ULL << 36);
+    const uint64_t occ = b.occ().getBits();
+    auto side = [&](Color c) {
+        const uint64_t own = b.us(c).getBits();
+        int mobility = 0, center = 0;
+        auto count = [&](PieceType pt, bool mobile) {
+            for (uint64_t bb = b.pieces(pt, c).getBits(); bb; bb &= bb - 1) {
+                Square sq(__builtin_ctzll(bb));
+                uint64_t att = pt == PieceType::PAWN     ? attacks::pawn(c, sq).getBits()
+                             : pt == PieceType::KNIGHT ? attacks::knight(sq).getBits()
+                             : pt == PieceType::BISHOP ? attacks::bishop(sq, occ).getBits()
+                             : pt == PieceType::ROOK   ? attacks::rook(sq, occ).getBits()
+                             : pt == PieceType::QUEEN  ? attacks::queen(sq, occ).getBits()
+                                                       : attacks::king(sq).getBits();
+                if (mobile) mobility += __builtin_popcountll(att & ~own);
+                center += __builtin_popcountll(att & CENTER);
+            }
+        };
+        count(PieceType::PAWN, false);
+        count(PieceType::KNIGHT, true);
+        count(PieceType::BISHOP, true);
+        count(PieceType::ROOK, true);
+        count(PieceType::QUEEN, true);
+        count(PieceType::KING, false);
+        return pst::MOBILITY * mobility + pst::CENTER_CONTROL * center;
+    };
+    return side(Color::WHITE) - side(Color::BLACK);
+}
+
+} // namespace
+
+namespace microbench {
+
+void movegen() {
+    std::vector<Board> boards;
+    for (const char* fen : POSITIONS) boards.emplace_back(fen);
+
+    constexpr int ROUNDS = 50000;
+    const uint64_t calls = (uint64_t)ROUNDS * boards.size();
+    volatile int sink = 0;
+    Movelist ml;
+
+    double all = ns_per_call(calls, [&] {
+        for (int r = 0; r < ROUNDS; ++r)
+            for (const auto& b : boards) {
+                movegen::legalmoves(ml, b);
+                sink = sink + ml.size();
+            }
+    });
+    double captures = ns_per_call(calls, [&] {
+        for (int r = 0; r < ROUNDS; ++r)
+            for (const auto& b : boards) {
+                movegen::legalmoves<movegen::MoveGenType::CAPTURE>(ml, b);
+                sink = sink + ml.size();
+            }
+    });
+
+    std::cout << "info string microbench movegen positions " << boards.size()
+              << " calls " << calls
+              << " legal_ns " << all
+              << " captures_ns " << captures << "\n" << std::flush;
+}
+
+void see() {
+    std::vector<std::pair<Board, Move>> work;
+    for (const char* fen : POSITIONS) {
+        Board b(fen);
+        Movelist ml;
+        movegen::legalmoves<movegen::MoveGenType::CAPTURE>(ml, b);
+        for (const auto& m : ml) work.emplace_back(b, m);
+    }
+    if (work.empty()) return;
+
+    constexpr int ROUNDS = 20000;
+    uint64_t calls = (uint64_t)ROUNDS * work.size();
+    volatile int sink = 0;
+
+    double seeNs = ns_per_call(calls, [&] {
+        for (int r = 0; r < ROUNDS; ++r)
+            for (const auto& [b, m] : work) sink = sink + ::see(b, m, 0);
+    });
+    double mvvLvaNs = ns_per_call(calls, [&] {
+        for (int r = 0; r < ROUNDS; ++r)
+            for (const auto& [b, m] : work) sink = sink + mvv_lva(b, m);
+    });
+
+    std::cout << "info string microbench see captures " << work.size()
+              << " calls " << calls
+              << " see_ns " << seeNs
+              << " mvv_lva_ns " << mvvLvaNs << "\n" << std::flush;
+}
+
+void eval() {
+    std::vector<Board> boards;
+    for (const char* fen : POSITIONS) boards.emplace_back(fen);
+
+    // Both versions must agree before their speed means anything
+    for (const auto& b : boards) {
+        if (mobility_and_center_per_piece(b) != eval::mobility_and_center(b)) {
+            std::cout << "info string microbench eval mismatch " << b.getFen() << "\n" << std::flush;
+            return;
+        }
+    }
+
+    constexpr int ROUNDS = 200000;
+    uint64_t calls = (uint64_t)ROUNDS * boards.size();
+    volatile int sink = 0;
+
+    double perPiece = ns_per_call(calls, [&] {
+        for (int r = 0; r < ROUNDS; ++r)
+            for (const auto& b : boards) sink = sink + mobility_and_center_per_piece(b).mg();
+    });
+    double setwise = ns_per_call(calls, [&] {
+        for (int r = 0; r < ROUNDS; ++r)
+            for (const auto& b : boards) sink = sink + eval::mobility_and_center(b).mg();
+    });
+    double evaluate = ns_per_call(calls / 10, [&] {
+        for (int r = 0; r < ROUNDS / 10; ++r)
+            for (const auto& b : boards) sink = sink + eval::evaluate(b);
+    });
+
+    std::cout << "info string microbench eval positions " << boards.size()
+              << " calls " << calls
+              << " attacks_per_piece_ns " << perPiece
+              << " attacks_setwise_ns " << setwise
+              << " evaluate_ns " << evaluate << "\n" << std::flush;
+}
+
+void tt() {
+    // Far more keys than cache lines in the cache, as in a real search
+    constexpr size_t MB = 64;
+    constexpr int KEYS = 1 << 20;
+    TranspositionTable table(MB);
+    std::mt19937_64 rng(20240611);
+    std::vector<uint64_t> keys(KEYS), missing(KEYS);
+    for (auto& k : keys) k = rng();
+    for (auto& k : missing) k = rng();
+
+    volatile int sink = 0;
+    double store = ns_per_call(KEYS, [&] {
+        for (int i = 0; i < KEYS; ++i) table.store(keys[i], (uint16_t)i, i & 31, i & 1023, (uint8_t)(i % 3));
+    });
+    double hit = ns_per_call(KEYS, [&] {
+        TTEntry e;
+        for (uint64_t k : keys) sink = sink + table.probe(k, e);
+    });
+    double miss = ns_per_call(KEYS, [&] {
+        TTEntry e;
+        for (uint64_t k : missing) sink = sink + table.probe(k, e);
+    });
+
+    std::cout << "info string microbench tt mb " << MB
+              << " keys " << KEYS
+              << " store_ns " << store
+              << " probe_hit_ns " << hit
+              << " probe_miss_ns " << miss << "\n" << std::flush;
+}
+
+void run(const std::string& name) {
+    if (name.empty() || name == "movegen") movegen();
+    if (name.empty() || name == "see") see();
+    if (name.empty() || name == "eval") eval();
+    if (name.empty() || name == "tt") tt();
+}
+
+} // namespace microbench
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+// Each figure is the fastest of REPEATS timed runs after a warm-up run, over
+// fixed inputs, so repeated runs on an idle machine agree closely.
+namespace microbench {
+
+constexpr int REPEATS = 5;
+
+// Time legal move generation (all moves, and captures only) over a fixed
+// position set; prints ns per position
+void movegen();
+
+// Time the static exchange evaluator (and MVV-LVA for reference) over the
+// captures of a fixed position set; prints ns per call
+void see();
+
+// Time the mobility/center terms set-wise (as evaluate() computes them)
+// against the former per-piece loops, and a full evaluate() without caches;
+// prints ns per position
+void eval();
+
+// Time transposition table stores, probes that hit and probes that miss,
+// with keys from a fixed seed; prints ns per operation
+void tt();
+
+// Run the named micro-benchmark ("movegen", "see", "eval", "tt"), or all of
+// them for an empty name
+void run(const std::string& name);
+
+} // namespace microbench
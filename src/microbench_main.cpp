@@ -0,0 +1,8 @@
+#include "microbench.hpp"
+#include <string>
+
+// Standalone micro-benchmarks: microbench [movegen|see|eval|tt]
+int main(int argc, char** argv) {
+    microbench::run(argc > 1 ? argv[1] : "");
+    return 0;
+}
@@ -1,30 +1,62 @@
 #pragma once
 #include "external/chess/include/chess.hpp"
+#include "see.hpp"
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
 
 using namespace chess;
 
+// History of one move by the [piece][to] it plays
+using PieceToHistory = int16_t[12][64];
+
+// Move ordering statistics of one search thread, in one block:
+//   butterfly     quiets by [side][from][to]
+//   capture       captures by [piece][to][captured piece type]
+//   continuation  quiets by the [piece][to] of the move 1 or 2 plies earlier,
+//                 then [piece][to] of the move itself
+// Entries move by gravity: a bonus b becomes h += b - h * |b| / MAX, so they
+// stay within +-MAX and each new result weighs more than the old ones.
 struct History {
-    // Simple history heuristic: from->to (64x64)
-    int16_t table[64][64] {};
-    void clear() { for (auto &row : table) for (auto &x : row) x = 0; }
-    void bonus(const Move& m, int v) {
-        auto f = m.from().index(), t = m.to().index();
-        int nv = table[f][t] + v;
-        table[f][t] = (int16_t)std::max(-30000, std::min(30000, nv));
-    }
-    int score(const Move& m) const { return table[m.from().index()][m.to().index()]; }
-};
+    static constexpr int MAX = 16384;
+
+    int16_t butterfly[2][64][64];
+    int16_t capture[12][64][6];
+    PieceToHistory continuation[12][64];
+
+    void clear() { std::memset(this, 0, sizeof(*this)); }
+
+    static void update(int16_t& h, int bonus) {
+        bonus = std::clamp(bonus, -MAX, MAX);
+        h += bonus - h * std::abs(bonus) / MAX;
+    }
 
-struct Killers {
-    // two killer moves per ply
-    chess::Move m1[256] {}, m2[256] {};
-    void clear() { for (int i=0;i<256;++i){ m1[i]=Move::NO_MOVE; m2[i]=Move::NO_MOVE; } }
-    void push(int ply, chess::Move m) {
-        if (m == m1[ply] || m == m2[ply]) return;
-        m2[ply] = m1[ply]; m1[ply] = m;
+    int16_t& quiet(const chess::Board& b, chess::Move m) {
+        return butterfly[(int)b.sideToMove()][m.from().index()][m.to().index()];
+    }
+    int16_t& captured(const chess::Board& b, chess::Move m) {
+        // En passant is the one capture whose target square is empty
+        const int victim = m.typeOf() == chess::Move::ENPASSANT ? (int)chess::PieceType::PAWN
+                                                                : (int)b.at(m.to()).type();
+        return capture[(int)b.at(m.from())][m.to().index()][victim];
+    }
+    // Continuation entry to follow the move `m` from `b`
+    PieceToHistory& continuationAfter(const chess::Board& b, chess::Move m) {
+        return continuation[(int)b.at(m.from())][m.to().index()];
     }
-    bool is_killer(int ply, chess::Move m) const { return m == m1[ply] || m == m2[ply]; }
+
+    int quiet(const chess::Board& b, chess::Move m) const { return const_cast<History*>(this)->quiet(b, m); }
+    int captured(const chess::Board& b, chess::Move m) const { return const_cast<History*>(this)->captured(b, m); }
+};
+
+// Move lists and scores of one MovePicker. The search keeps one per ply on
+// its SearchStack, so pickers carry no storage of their own.
+struct MoveBuffer {
+    chess::Movelist captures, quiets;
+    int capScores[256];
+    int quietScores[256];
 };
 
 // MVV-LVA like score (bigger is better)
@@ -45,3 +77,181 @@ inline int mvv_lva(const chess::Board& b, chess::Move m) {
     int attackerVal = V[(int)attacker.type()];
     return 10000 + victimVal * 16 - attackerVal;
 }
+
+// Staged move picker. Moves come out in the order
+//   TT move, captures with SEE >= 0, killers, quiets by history, losing captures
+// Captures are ranked by MVV-LVA plus their capture history, quiets by their
+// butterfly history plus the continuation histories of the two moves before.
+// and each stage generates and scores its moves only when it is reached. Moves
+// are picked by incremental selection, so a cutoff early in the list skips the
+// remaining sorting (and a TT-move cutoff skips move generation entirely).
+class MovePicker {
+public:
+    // Main search, with the two killer moves of the node's ply and the
+    // continuation histories after the moves 1 and 2 plies back (null if none)
+    MovePicker(const chess::Board& b, MoveBuffer& buf, chess::Move ttMove,
+               const chess::Move (&killers)[2], const History& history,
+               const PieceToHistory* const (&cont)[2])
+        : b_(b), history_(history), cont_{cont[0], cont[1]}, ttMove_(ttMove),
+          killer1_(killers[0]), killer2_(killers[1]),
+          captures_(buf.captures), quiets_(buf.quiets),
+          capScores_(buf.capScores), quietScores_(buf.quietScores) {}
+
+    // Quiescence search: captures and queen promotions that do not lose
+    // material, unless the side to move is in check, in which case all
+    // evasions are returned
+    MovePicker(const chess::Board& b, MoveBuffer& buf, const History& history, bool inCheck)
+        : b_(b), history_(history), ttMove_(chess::Move::NO_MOVE),
+          killer1_(chess::Move::NO_MOVE), killer2_(chess::Move::NO_MOVE),
+          skipQuiets_(!inCheck), captures_(buf.captures), quiets_(buf.quiets),
+          capScores_(buf.capScores), quietScores_(buf.quietScores) {}
+
+    // Next move to search, or Move::NO_MOVE when exhausted
+    chess::Move next();
+
+private:
+    enum class Stage : uint8_t {
+        TT_MOVE, GEN_CAPTURES, GOOD_CAPTURES, GEN_QUIETS, KILLER1, KILLER2,
+        QUIETS, BAD_CAPTURES, DONE
+    };
+
+    // Offset of captures that lose material (and under-promotions). Good
+    // captures score within a few ten thousands of zero, and may be negative
+    // (MVV-LVA puts king captures below zero), so the two groups are told
+    // apart by this offset rather than by sign.
+    static constexpr int BAD_CAPTURE = -1000000;
+    static constexpr bool isBadCapture(int score) { return score < BAD_CAPTURE / 2; }
+
+    // Legality check for a move from the TT or killer slots that only
+    // generates moves of the moving piece type
+    bool isLegal(chess::Move m) const {
+        using namespace chess;
+        if (m == Move::NO_MOVE) return false;
+        Piece p = b_.at(m.from());
+        if (p == Piece::NONE || p.color() != b_.sideToMove()) return false;
+        Movelist ml;
+        movegen::legalmoves(ml, b_, 1 << (int)p.type());
+        return contains(ml, m);
+    }
+
+    static bool contains(const chess::Movelist& ml, chess::Move m) {
+        for (const auto& x : ml) if (x == m) return true;
+        return false;
+    }
+
+    int captureScore(chess::Move m) const {
+        using namespace chess;
+        static constexpr int V[7] = {100, 320, 330, 500, 900, 20000, 0};
+        int s = mvv_lva(b_, m);
+        if (b_.isCapture(m)) s += history_.captured(b_, m) / 8;
+        if (m.typeOf() == Move::PROMOTION) {
+            // Under-promotions are almost never best
+            if (m.promotionType() != PieceType::QUEEN) return BAD_CAPTURE + s;
+            s += 10000 + V[(int)PieceType::QUEEN] * 16;
+        }
+        if (!see(b_, m, 0)) s += BAD_CAPTURE;
+        return s;
+    }
+
+    int quietScore(chess::Move m) const {
+        int s = history_.quiet(b_, m);
+        const int pc = (int)b_.at(m.from()), to = m.to().index();
+        if (cont_[0]) s += (*cont_[0])[pc][to];
+        if (cont_[1]) s += (*cont_[1])[pc][to];
+        return s;
+    }
+
+    // Selection step: swap the best remaining move to index `cur`
+    static void selectBest(chess::Movelist& ml, int* scores, int cur) {
+        int best = cur;
+        for (int i = cur + 1; i < ml.size(); ++i)
+            if (scores[i] > scores[best]) best = i;
+        if (best != cur) {
+            std::swap(ml[cur], ml[best]);
+            std::swap(scores[cur], scores[best]);
+        }
+    }
+
+    const chess::Board& b_;
+    const History& history_;
+    const PieceToHistory* cont_[2] = {nullptr, nullptr};
+    chess::Move ttMove_, killer1_, killer2_;
+    Stage stage_ = Stage::TT_MOVE;
+    bool skipQuiets_ = false;
+
+    chess::Movelist& captures_;
+    chess::Movelist& quiets_;
+    int* capScores_;
+    int* quietScores_;
+    int capCur_ = 0, quietCur_ = 0;
+};
+
+inline chess::Move MovePicker::next() {
+    using namespace chess;
+    switch (stage_) {
+    case Stage::TT_MOVE:
+        stage_ = Stage::GEN_CAPTURES;
+        if (isLegal(ttMove_)) return ttMove_;
+        [[fallthrough]];
+
+    case Stage::GEN_CAPTURES:
+        movegen::legalmoves<movegen::MoveGenType::CAPTURE>(captures_, b_);
+        for (int i = 0; i < captures_.size(); ++i) capScores_[i] = captureScore(captures_[i]);
+        stage_ = Stage::GOOD_CAPTURES;
+        [[fallthrough]];
+
+    case Stage::GOOD_CAPTURES:
+        while (capCur_ < captures_.size()) {
+            selectBest(captures_, capScores_, capCur_);
+            if (isBadCapture(capScores_[capCur_])) break; // rest are losing captures
+            Move m = captures_[capCur_++];
+            if (m != ttMove_) return m;
+        }
+        if (skipQuiets_) {
+            // Losing captures are pruned in quiescence
+            stage_ = Stage::DONE;
+            break;
+        }
+        stage_ = Stage::GEN_QUIETS;
+        [[fallthrough]];
+
+    case Stage::GEN_QUIETS:
+        movegen::legalmoves<movegen::MoveGenType::QUIET>(quiets_, b_);
+        stage_ = Stage::KILLER1;
+        [[fallthrough]];
+
+    case Stage::KILLER1:
+        stage_ = Stage::KILLER2;
+        if (killer1_ != ttMove_ && contains(quiets_, killer1_)) return killer1_;
+        [[fallthrough]];
+
+    case Stage::KILLER2:
+        stage_ = Stage::QUIETS;
+        // Promotions come with the captures (see captureScore), never here
+        for (int i = 0; i < quiets_.size(); ++i) quietScores_[i] = quietScore(quiets_[i]);
+        if (killer2_ != ttMove_ && killer2_ != killer1_ && contains(quiets_, killer2_)) return killer2_;
+        [[fallthrough]];
+
+    case Stage::QUIETS:
+        while (quietCur_ < quiets_.size()) {
+            selectBest(quiets_, quietScores_, quietCur_);
+            Move m = quiets_[quietCur_++];
+            if (m != ttMove_ && m != killer1_ && m != killer2_) return m;
+        }
+        stage_ = Stage::BAD_CAPTURES;
+        [[fallthrough]];
+
+    case Stage::BAD_CAPTURES:
+        while (capCur_ < captures_.size()) {
+            selectBest(captures_, capScores_, capCur_);
+            Move m = captures_[capCur_++];
+            if (m != ttMove_) return m;
+        }
+        stage_ = Stage::DONE;
+        [[fallthrough]];
+
+    case Stage::DONE:
+        break;
+    }
+    return chess::Move::NO_MOVE;
+}
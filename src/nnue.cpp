@@ -0,0 +1,249 @@
+#include "nnue.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#if defined(__AVX512BW__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace chess;
+
+namespace {
+
+using nnue::HIDDEN;
+
+constexpr size_t HEADER_SIZE = 64;
+constexpr uint32_t VERSION = 1;
+constexpr size_t FILE_SIZE = HEADER_SIZE
+                           + sizeof(int16_t) * HIDDEN
+                           + sizeof(int16_t) * (size_t)nnue::INPUTS * HIDDEN
+                           + sizeof(int8_t) * 2 * HIDDEN
+                           + sizeof(int32_t);
+
+// King bucket by square, after orienting and mirroring the king to files a-d:
+// a few on the back rank, where the king spends the middlegame, then coarser
+const int KING_BUCKET[64] = {
+    0, 1, 2, 3, 3, 2, 1, 0,
+    4, 4, 5, 5, 5, 5, 4, 4,
+    6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6,
+    7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7,
+};
+
+// Square transform and bucket base of one perspective, fixed by its king
+struct View {
+    int flip;   // XOR-ed into squares: rank flip for Black, file mirror for e-h kings
+    int base;   // first input of the king's bucket
+    int color;
+
+    View(const Board& b, Color persp) : color((int)persp) {
+        int k = b.kingSq(persp).index() ^ (persp == Color::BLACK ? 56 : 0);
+        flip = (persp == Color::BLACK ? 56 : 0) ^ ((k & 7) >= 4 ? 7 : 0);
+        base = KING_BUCKET[k] * 12 * 64;
+    }
+
+    int feature(Piece pc, int sq) const {
+        const int side = (int)pc.color() == color ? 0 : 6;
+        return base + (side + (int)pc.type()) * 64 + (sq ^ flip);
+    }
+};
+
+// dst = src + sum(add) - sum(sub), HIDDEN int16 lanes, wrapping
+void update(int16_t* dst, const int16_t* src,
+            const int16_t* const* add, int nAdd, const int16_t* const* sub, int nSub) {
+#if defined(__AVX512BW__)
+    for (int i = 0; i < HIDDEN; i += 32) {
+        __m512i v = _mm512_loadu_si512(src + i);
+        for (int a = 0; a < nAdd; ++a) v = _mm512_add_epi16(v, _mm512_loadu_si512(add[a] + i));
+        for (int s = 0; s < nSub; ++s) v = _mm512_sub_epi16(v, _mm512_loadu_si512(sub[s] + i));
+        _mm512_storeu_si512(dst + i, v);
+    }
+#elif defined(__AVX2__)
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        for (int a = 0; a < nAdd; ++a)
+            v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i*)(add[a] + i)));
+        for (int s = 0; s < nSub; ++s)
+            v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i*)(sub[s] + i)));
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+    }
+#elif defined(__ARM_NEON)
+    for (int i = 0; i < HIDDEN; i += 8) {
+        int16x8_t v = vld1q_s16(src + i);
+        for (int a = 0; a < nAdd; ++a) v = vaddq_s16(v, vld1q_s16(add[a] + i));
+        for (int s = 0; s < nSub; ++s) v = vsubq_s16(v, vld1q_s16(sub[s] + i));
+        vst1q_s16(dst + i, v);
+    }
+#else
+    for (int i = 0; i < HIDDEN; ++i) {
+        int v = src[i];
+        for (int a = 0; a < nAdd; ++a) v += add[a][i];
+        for (int s = 0; s < nSub; ++s) v -= sub[s][i];
+        dst[i] = (int16_t)v;
+    }
+#endif
+}
+
+// sum of clamp(acc[i], 0, QA) * w[i] over HIDDEN lanes
+int32_t dot(const int16_t* acc, const int8_t* w) {
+#if defined(__AVX512BW__)
+    const __m512i zero = _mm512_setzero_si512(), qa = _mm512_set1_epi16(nnue::QA);
+    __m512i sum = _mm512_setzero_si512();
+    for (int i = 0; i < HIDDEN; i += 32) {
+        __m512i a = _mm512_min_epi16(_mm512_max_epi16(_mm512_loadu_si512(acc + i), zero), qa);
+        __m512i b = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(w + i)));
+        sum = _mm512_add_epi32(sum, _mm512_madd_epi16(a, b));
+    }
+    // Spelled out: GCC 12's _mm512_reduce_add_epi32 trips -Wuninitialized
+    alignas(64) int32_t lanes[16];
+    _mm512_store_si512(lanes, sum);
+    int32_t total = 0;
+    for (int32_t l : lanes) total += l;
+    return total;
+#elif defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256(), qa = _mm256_set1_epi16(nnue::QA);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+        a = _mm256_min_epi16(_mm256_max_epi16(a, zero), qa);
+        __m256i b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(w + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, b));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+#elif defined(__ARM_NEON)
+    const int16x8_t zero = vdupq_n_s16(0), qa = vdupq_n_s16(nnue::QA);
+    int32x4_t sum = vdupq_n_s32(0);
+    for (int i = 0; i < HIDDEN; i += 8) {
+        int16x8_t a = vminq_s16(vmaxq_s16(vld1q_s16(acc + i), zero), qa);
+        int16x8_t b = vmovl_s8(vld1_s8(w + i));
+        sum = vmlal_s16(sum, vget_low_s16(a), vget_low_s16(b));
+        sum = vmlal_s16(sum, vget_high_s16(a), vget_high_s16(b));
+    }
+    return vaddvq_s32(sum);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < HIDDEN; ++i) sum += std::clamp<int>(acc[i], 0, nnue::QA) * w[i];
+    return sum;
+#endif
+}
+
+uint32_t read_u32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace
+
+namespace nnue {
+
+std::unique_ptr<Network> Network::load(const std::string& path, std::string& error) {
+    std::unique_ptr<Network> net(new Network(path));
+    if (!net->file_.ok()) {
+        error = "cannot read " + path;
+        return nullptr;
+    }
+    std::string_view data = net->file_.view();
+    if (data.size() != FILE_SIZE || std::memcmp(data.data(), "MINNUE1", 8) != 0
+        || read_u32(data.data() + 8) != VERSION || read_u32(data.data() + 12) != (uint32_t)INPUTS
+        || read_u32(data.data() + 16) != (uint32_t)HIDDEN) {
+        error = path + " is not a Minerva network (version " + std::to_string(VERSION) + ", "
+              + std::to_string(INPUTS) + "x" + std::to_string(HIDDEN) + ")";
+        return nullptr;
+    }
+
+    const char* p = data.data() + HEADER_SIZE;
+    net->ftBias_ = reinterpret_cast<const int16_t*>(p);
+    p += sizeof(int16_t) * HIDDEN;
+    net->ftWeights_ = reinterpret_cast<const int16_t*>(p);
+    p += sizeof(int16_t) * (size_t)INPUTS * HIDDEN;
+    net->outWeights_ = reinterpret_cast<const int8_t*>(p);
+    p += 2 * HIDDEN;
+    std::memcpy(&net->outBias_, p, sizeof(int32_t));
+    return net;
+}
+
+void Network::refresh(Accumulator& acc, const Board& b) const {
+    for (Color persp : {Color::WHITE, Color::BLACK}) {
+        const int c = (int)persp;
+        if (!acc.dirty[c]) continue;
+        const View view(b, persp);
+        std::memcpy(acc.v[c], ftBias_, sizeof(acc.v[c]));
+        uint64_t occ = b.occ().getBits();
+        while (occ) {
+            int sq = __builtin_ctzll(occ);
+            occ &= occ - 1;
+            const int16_t* col = ftWeights_ + (size_t)view.feature(b.at(Square(sq)), sq) * HIDDEN;
+            update(acc.v[c], acc.v[c], &col, 1, nullptr, 0);
+        }
+        acc.dirty[c] = false;
+    }
+}
+
+void Network::apply_move(Accumulator& next, const Accumulator& prev, const Board& b, Move m) const {
+    const int from = m.from().index();
+    const int to = m.to().index();
+    const Piece p = b.at(m.from());
+
+    for (Color persp : {Color::WHITE, Color::BLACK}) {
+        const int c = (int)persp;
+        // Own king moves may change the bucket: rebuilt lazily in evaluate()
+        next.dirty[c] = prev.dirty[c] || (p.type() == PieceType::KING && p.color() == persp);
+        if (next.dirty[c]) continue;
+
+        const View view(b, persp);
+        const int16_t* add[2];
+        const int16_t* sub[2];
+        int nAdd = 0, nSub = 0;
+        auto col = [&](Piece pc, int sq) { return ftWeights_ + (size_t)view.feature(pc, sq) * HIDDEN; };
+
+        if (m.typeOf() == Move::CASTLING) {
+            // Encoded as king takes own rook; destinations are the g/c and f/d files
+            const Piece rook = b.at(m.to());
+            const int rank = from & 56;
+            const bool kingSide = to > from;
+            sub[nSub++] = col(p, from);
+            sub[nSub++] = col(rook, to);
+            add[nAdd++] = col(p, rank + (kingSide ? 6 : 2));
+            add[nAdd++] = col(rook, rank + (kingSide ? 5 : 3));
+        } else {
+            if (m.typeOf() == Move::ENPASSANT) {
+                const int capSq = m.to().ep_square().index();
+                sub[nSub++] = col(b.at(Square(capSq)), capSq);
+            } else if (b.at(m.to()) != Piece::NONE) {
+                sub[nSub++] = col(b.at(m.to()), to);
+            }
+            sub[nSub++] = col(p, from);
+            add[nAdd++] = m.typeOf() == Move::PROMOTION ? col(Piece(m.promotionType(), p.color()), to)
+                                                        : col(p, to);
+        }
+        update(next.v[c], prev.v[c], add, nAdd, sub, nSub);
+    }
+}
+
+int Network::evaluate(Accumulator& acc, const Board& b) const {
+    refresh(acc, b);
+#ifndef NDEBUG
+    // Incremental updates must match a full rebuild
+    Accumulator fresh;
+    refresh(fresh, b);
+    assert(std::memcmp(fresh.v, acc.v, sizeof(acc.v)) == 0);
+#endif
+
+    const int us = (int)b.sideToMove();
+    int64_t out = (int64_t)dot(acc.v[us], outWeights_) + dot(acc.v[us ^ 1], outWeights_ + HIDDEN) + outBias_;
+    int score = (int)(out * SCALE / (QA * QB));
+    const int bound = ::utils::MATE - ::utils::MATE_IN_MAX - 1;
+    return std::clamp(score, -bound, bound);
+}
+
+} // namespace nnue
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "external/chess/include/chess.hpp"
+#include "mapped_file.hpp"
+
+// NNUE evaluation, the alternative to the hand-written eval::evaluate().
+//
+// Inputs are king-bucketed piece-square features per perspective: the board
+// is seen from each side (ranks flipped for Black) and mirrored so that side's
+// king sits on files a-d; the king square then picks one of KING_BUCKETS
+// buckets of 12 x 64 (own/their piece type x square) inputs. A feature
+// transformer (int16) maps each perspective to HIDDEN values, updated
+// incrementally as moves are made; the clipped side-to-move and opponent
+// halves feed one int8 output neuron.
+namespace nnue {
+
+constexpr int KING_BUCKETS = 8;
+constexpr int INPUTS = KING_BUCKETS * 12 * 64;
+constexpr int HIDDEN = 256;
+constexpr int QA = 255;    // feature transformer scale; activations clip to [0, QA]
+constexpr int QB = 64;     // output weight scale
+constexpr int SCALE = 400; // network output to centipawns
+
+// Feature transformer output for both perspectives, [Color][HIDDEN]. One per
+// ply on the search stack. apply_move() marks a side whose king moved dirty,
+// as its bucket or mirroring may have changed, and children inherit the flag;
+// refresh() rebuilds it from the board. The search refreshes right after the
+// king move, so the rebuild happens once and not at each node below.
+struct Accumulator {
+    alignas(64) int16_t v[2][HIDDEN];
+    bool dirty[2] = {true, true};
+};
+
+// Little-endian network file: a 64-byte header ("MINNUE1", version, INPUTS,
+// HIDDEN), then the feature biases int16[HIDDEN], the feature weights
+// int16[INPUTS][HIDDEN], the output weights int8[2 * HIDDEN] (side to move's
+// half first) and the output bias int32. The weights are used in place from
+// the memory-mapped file.
+class Network {
+public:
+    // Load `path`; on failure returns null and sets `error`
+    static std::unique_ptr<Network> load(const std::string& path, std::string& error);
+
+    const std::string& path() const { return path_; }
+
+    // Rebuild the dirty perspectives of `acc` from `b`
+    void refresh(Accumulator& acc, const chess::Board& b) const;
+    // Derive `next` from `prev` for move `m`; `b` is the position before it
+    void apply_move(Accumulator& next, const Accumulator& prev, const chess::Board& b, chess::Move m) const;
+    // Side-to-move score in centipawns; `acc` must belong to `b`
+    int evaluate(Accumulator& acc, const chess::Board& b) const;
+
+private:
+    explicit Network(const std::string& path) : path_(path), file_(path, false) {}
+
+    std::string path_;
+    MappedFile file_;
+    const int16_t* ftBias_ = nullptr;
+    const int16_t* ftWeights_ = nullptr;
+    const int8_t* outWeights_ = nullptr;
+    int32_t outBias_ = 0;
+};
+
+} // namespace nnue
@@ -0,0 +1,95 @@
+#include "output.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+
+namespace {
+
+// write(2) all of [p, p + n); output that cannot be written is dropped
+void write_all(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+}
+
+} // namespace
+
+namespace output {
+
+void Queue::push(std::string_view s) {
+    while (!s.empty()) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t room = SIZE - (tail - head);
+        if (room == 0) {
+            head_.wait(head, std::memory_order_acquire);
+            continue;
+        }
+        const size_t n = std::min(room, s.size());
+        const size_t at = tail % SIZE;
+        const size_t first = std::min(n, SIZE - at);
+        std::memcpy(buf_ + at, s.data(), first);
+        std::memcpy(buf_, s.data() + first, n - first);
+        tail_.store(tail + n, std::memory_order_release);
+        s.remove_prefix(n);
+        writer_.wake();
+    }
+}
+
+Writer::Writer(int fd) : fd_(fd) {
+    thread_ = std::thread([this] { run(); });
+}
+
+Writer::~Writer() {
+    quit_.store(true, std::memory_order_release);
+    wake();
+    thread_.join();
+}
+
+void Writer::flush() {
+    for (Queue* q : {&search_, &control_}) {
+        const size_t tail = q->tail_.load(std::memory_order_acquire);
+        for (size_t head; (head = q->head_.load(std::memory_order_acquire)) < tail;)
+            q->head_.wait(head, std::memory_order_acquire);
+    }
+}
+
+bool Writer::drain(Queue& q, size_t tail) {
+    const size_t head = q.head_.load(std::memory_order_relaxed);
+    if (head == tail) return false;
+    const size_t at = head % Queue::SIZE;
+    const size_t n = tail - head;
+    const size_t first = std::min(n, Queue::SIZE - at);
+    write_all(fd_, q.buf_ + at, first);
+    write_all(fd_, q.buf_, n - first);
+    q.head_.store(tail, std::memory_order_release);
+    q.head_.notify_all();
+    return true;
+}
+
+void Writer::run() {
+    while (true) {
+        const uint32_t seen = wake_.load(std::memory_order_acquire);
+        // The control queue is read first: whatever the search queued before
+        // the control thread queued this is then visible and goes out first
+        const size_t controlTail = control_.tail_.load(std::memory_order_acquire);
+        const size_t searchTail = search_.tail_.load(std::memory_order_acquire);
+        const bool wrote = drain(search_, searchTail) | drain(control_, controlTail);
+        if (wrote) continue;
+        if (quit_.load(std::memory_order_acquire)) {
+            // Anything pushed before the shutdown is visible now
+            drain(search_, search_.tail_.load(std::memory_order_acquire));
+            drain(control_, control_.tail_.load(std::memory_order_acquire));
+            return;
+        }
+        wake_.wait(seen, std::memory_order_acquire);
+    }
+}
+
+} // namespace output
@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+// UCI output off the calling threads. Each thread that prints owns one Queue,
+// a single-producer single-consumer ring of bytes; one Writer thread drains
+// the queues to a file descriptor. Pushing copies the text and wakes the
+// writer through an atomic, so no search thread takes a lock or waits on
+// the terminal (unless its queue is full).
+namespace output {
+
+class Writer;
+
+class Queue {
+public:
+    static constexpr size_t SIZE = 1 << 16;
+
+    // Producer side: append `s`, waiting for room while the ring is full
+    void push(std::string_view s);
+
+private:
+    friend class Writer;
+    explicit Queue(Writer& w) : writer_(w) {}
+
+    Writer& writer_;
+    alignas(64) std::atomic<size_t> head_{0}; // bytes written out; consumer only
+    alignas(64) std::atomic<size_t> tail_{0}; // bytes queued; producer only
+    alignas(64) char buf_[SIZE];
+};
+
+// Owns the queues of the two UCI producers and the thread that writes them:
+// `search()` for the main search thread (info lines and bestmove), `control()`
+// for the thread reading commands. Text the control thread queues after
+// seeing a search finish is written after that search's output.
+class Writer {
+public:
+    explicit Writer(int fd = 1);
+    // Writes out everything queued, then joins the writer thread
+    ~Writer();
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    Queue& search() { return search_; }
+    Queue& control() { return control_; }
+    // Block until everything queued so far has been written, e.g. before
+    // printing through std::cout directly
+    void flush();
+
+private:
+    friend class Queue;
+    void wake() {
+        wake_.fetch_add(1, std::memory_order_release);
+        wake_.notify_one();
+    }
+    void run();
+    // Write q's bytes up to `tail`; false if there were none
+    bool drain(Queue& q, size_t tail);
+
+    int fd_;
+    std::atomic<uint32_t> wake_{0}; // bumped by every push and by shutdown
+    std::atomic<bool> quit_{false};
+    Queue search_{*this};
+    Queue control_{*this};
+    std::thread thread_;
+};
+
+// Fixed-size text buffer for formatting a line without iostreams or
+// allocation; text beyond the capacity is dropped
+class Line {
+public:
+    Line& operator<<(std::string_view s) {
+        const size_t n = std::min(s.size(), sizeof(buf_) - len_);
+        std::memcpy(buf_ + len_, s.data(), n);
+        len_ += n;
+        return *this;
+    }
+    Line& operator<<(char c) {
+        if (len_ < sizeof(buf_)) buf_[len_++] = c;
+        return *this;
+    }
+    template <std::integral T>
+    Line& operator<<(T v) {
+        auto r = std::to_chars(buf_ + len_, buf_ + sizeof(buf_), v);
+        if (r.ec == std::errc()) len_ = r.ptr - buf_;
+        return *this;
+    }
+
+    std::string_view view() const { return {buf_, len_}; }
+
+private:
+    char buf_[4096];
+    size_t len_ = 0;
+};
+
+} // namespace output
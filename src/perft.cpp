@@ -0,0 +1,80 @@
+#include "perft.hpp"
+#include "thread_pool.hpp"
+#include "uci.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace chess;
+
+namespace perft {
+
+PerftHash::PerftHash(size_t mb) {
+    size_t entries = std::bit_floor(std::max<size_t>(1, mb * 1024 * 1024 / sizeof(Entry)));
+    table_ = std::make_unique<Entry[]>(entries);
+    mask_ = entries - 1;
+}
+
+uint64_t count(Board& b, int depth, PerftHash* hash) {
+    if (depth <= 0) return 1;
+
+    uint64_t nodes = 0;
+    if (depth >= 2 && hash && hash->probe(b.hash(), depth, nodes)) return nodes;
+
+    Movelist ml;
+    movegen::legalmoves(ml, b);
+    if (depth == 1) return (uint64_t)ml.size();
+
+    for (const auto& m : ml) {
+        b.makeMove(m);
+        nodes += count(b, depth - 1, hash);
+        b.unmakeMove(m);
+    }
+    if (hash) hash->store(b.hash(), depth, nodes);
+    return nodes;
+}
+
+uint64_t divide(const Board& root, int depth, ThreadPool& pool, size_t hashMB, bool chess960) {
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+
+    Movelist rootMoves;
+    movegen::legalmoves(rootMoves, root);
+    std::vector<uint64_t> counts(rootMoves.size(), 0);
+
+    std::unique_ptr<PerftHash> hash;
+    if (hashMB > 0 && depth > 2) hash = std::make_unique<PerftHash>(hashMB);
+
+    // Threads take root moves one at a time until none are left
+    std::atomic<int> next{0};
+    if (depth > 1) {
+        pool.run([&](int) {
+            Board b = root;
+            for (int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < (int)rootMoves.size();) {
+                b.makeMove(rootMoves[i]);
+                counts[i] = count(b, depth - 1, hash.get());
+                b.unmakeMove(rootMoves[i]);
+            }
+        });
+    } else {
+        std::fill(counts.begin(), counts.end(), depth == 1 ? 1 : 0);
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < (int)rootMoves.size(); ++i) {
+        std::cout << UciDriver::move_to_uci(rootMoves[i], chess960) << ": " << counts[i] << "\n";
+        total += counts[i];
+    }
+    if (depth <= 0) total = 1;
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count();
+    std::cout << "\nNodes searched: " << total
+              << "\nTime (ms): " << ms
+              << "\nNodes/second: " << total * 1000 / (uint64_t)std::max<int64_t>(1, ms)
+              << "\n" << std::flush;
+    return total;
+}
+
+} // namespace perft
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "external/chess/include/chess.hpp"
+
+class ThreadPool;
+
+namespace perft {
+
+// Leaf counts keyed by position and remaining depth. Same lockless scheme as
+// the eval cache (key ^ data beside the data word), so pool threads can
+// share one table.
+class PerftHash {
+public:
+    explicit PerftHash(size_t mb);
+
+    bool probe(uint64_t key, int depth, uint64_t& count) const {
+        key = mix(key, depth);
+        const Entry& e = table_[key & mask_];
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        if ((e.check.load(std::memory_order_relaxed) ^ data) != key || !data) return false;
+        count = data;
+        return true;
+    }
+
+    void store(uint64_t key, int depth, uint64_t count) {
+        key = mix(key, depth);
+        Entry& e = table_[key & mask_];
+        e.check.store(key ^ count, std::memory_order_relaxed);
+        e.data.store(count, std::memory_order_relaxed);
+    }
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check{0}; // key ^ data
+        std::atomic<uint64_t> data{0};  // leaf count
+    };
+
+    static uint64_t mix(uint64_t key, int depth) {
+        return key ^ ((uint64_t)depth * 0x9E3779B97F4A7C15ULL);
+    }
+
+    std::unique_ptr<Entry[]> table_;
+    size_t mask_ = 0;
+};
+
+// Leaf nodes of the legal move tree below `b` at `depth`; the last ply is
+// bulk counted from the move list size
+uint64_t count(chess::Board& b, int depth, PerftHash* hash = nullptr);
+
+// Perft of `root` with its moves split across the threads of `pool`, using
+// a `hashMB` table (0 disables it). Prints "move: count" per root move, then
+// total nodes, time and nodes/second. Returns the total.
+uint64_t divide(const chess::Board& root, int depth, ThreadPool& pool,
+                size_t hashMB, bool chess960 = false);
+
+} // namespace perft
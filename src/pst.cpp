@@ -1,12 +1,14 @@
 #include "pst.hpp"
 
-namespace pst {
+namespace {
 
-const int OP_VALUE[6] = {82, 337, 365, 477, 1025, 0};
-const int MG_VALUE[6] = {82, 337, 365, 477, 1025, 0};
-const int EG_VALUE[6] = {94, 281, 297, 512, 936, 0};
+// PESTO piece values and piece-square tables indexed by White's square, one
+// per phase; folded into pst::PSQ below
+constexpr int OP_VALUE[6] = {82, 337, 365, 477, 1025, 0};
+constexpr int MG_VALUE[6] = {82, 337, 365, 477, 1025, 0};
+constexpr int EG_VALUE[6] = {94, 281, 297, 512, 936, 0};
 
-const int OP_PST[6][64] = {
+constexpr int OP_PST[6][64] = {
     { // Pawn
         0,   0,  0,   0,   0,   0,  0,  0,   98,  134, 61, 95,  68, 126, 34, -11,
         -6,  7,  26,  31,  65,  56, 25, -20, -14, 13,  6,  21,  23, 12,  17, -23,
@@ -50,7 +52,7 @@ const int OP_PST[6][64] = {
     }
 };
 
-const int MG_PST[6][64] = {
+constexpr int MG_PST[6][64] = {
     { // Pawn
         0,   0,  0,   0,   0,   0,  0,  0,   98,  134, 61, 95,  68, 126, 34, -11,
         -6,  7,  26,  31,  65,  56, 25, -20, -14, 13,  6,  21,  23, 12,  17, -23,
@@ -94,7 +96,7 @@ const int MG_PST[6][64] = {
     }
 };
 
-const int EG_PST[6][64] = {
+constexpr int EG_PST[6][64] = {
     { // Pawn
         0,  0,   0,  0,  0,  0,  0,  0,  178, 173, 158, 134, 147, 132, 165, 187,
         94, 100, 85, 67, 56, 53, 82, 84, 32,  24,  13,  5,   -2,  4,   17,  17,
@@ -136,5 +138,26 @@ const int EG_PST[6][64] = {
     }
 };
 
-} // namespace pst
+constexpr pst::PsqTable build_psq() {
+    pst::PsqTable t{};
+    for (int pt = 0; pt < 6; ++pt) {
+        for (int sq = 0; sq < 64; ++sq) {
+            const Score s(OP_VALUE[pt] + OP_PST[pt][sq], MG_VALUE[pt] + MG_PST[pt][sq],
+                          EG_VALUE[pt] + EG_PST[pt][sq]);
+            t.score[0][pt][sq] = s;
+            t.score[1][pt][sq ^ 56] = -s;
+        }
+    }
+    return t;
+}
 
+} // namespace
+
+namespace pst {
+
+constexpr PsqTable PSQ = build_psq();
+
+const Score MOBILITY{6, 4, 2};
+const Score CENTER_CONTROL{6, 4, 2};
+
+} // namespace pst
@@ -1,14 +1,20 @@
 #pragma once
+#include "score.hpp"
 
 namespace pst {
 
-extern const int OP_VALUE[6];
-extern const int MG_VALUE[6];
-extern const int EG_VALUE[6];
+// Piece value plus piece-square bonus by [color][piece type][square], from
+// White's side: Black's entries are rank-mirrored and negated, so the
+// material and PST of a position is the plain sum over its pieces. Built at
+// compile time from the per-phase PESTO tables in pst.cpp.
+struct PsqTable {
+    Score score[2][6][64];
+};
+extern const PsqTable PSQ;
 
-extern const int OP_PST[6][64];
-extern const int MG_PST[6][64];
-extern const int EG_PST[6][64];
+// Per attacked square: any square but an own piece's for knights, bishops,
+// rooks and queens; d4/e4/d5/e5 for every piece
+extern const Score MOBILITY;
+extern const Score CENTER_CONTROL;
 
 } // namespace pst
-
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+// Opening, middlegame and endgame values packed into one integer, so a term
+// is added to all three phases with a single add. Lanes are 21 bits apart;
+// each lane is read back by rounding off the lanes below it, which stays
+// exact while every lane is within +-2^20.
+class Score {
+public:
+    constexpr Score() = default;
+    constexpr Score(int op, int mg, int eg)
+        : v_((int64_t)op + (int64_t)mg * (int64_t(1) << 21) + (int64_t)eg * (int64_t(1) << 42)) {}
+
+    constexpr int eg() const { return (int)((v_ + (int64_t(1) << 41)) >> 42); }
+    constexpr int mg() const {
+        return (int)((v_ - (int64_t)eg() * (int64_t(1) << 42) + (int64_t(1) << 20)) >> 21);
+    }
+    constexpr int op() const {
+        return (int)(v_ - (int64_t)eg() * (int64_t(1) << 42) - (int64_t)mg() * (int64_t(1) << 21));
+    }
+
+    constexpr Score operator+(Score o) const { return raw(v_ + o.v_); }
+    constexpr Score operator-(Score o) const { return raw(v_ - o.v_); }
+    constexpr Score operator-() const { return raw(-v_); }
+    constexpr Score operator*(int k) const { return raw(v_ * k); }
+    constexpr Score& operator+=(Score o) { v_ += o.v_; return *this; }
+    constexpr Score& operator-=(Score o) { v_ -= o.v_; return *this; }
+    constexpr bool operator==(const Score&) const = default;
+
+private:
+    static constexpr Score raw(int64_t v) {
+        Score s;
+        s.v_ = v;
+        return s;
+    }
+
+    int64_t v_ = 0;
+};
+
+static_assert(Score(-3, 7, -11).op() == -3 && Score(-3, 7, -11).mg() == 7 && Score(-3, 7, -11).eg() == -11);
+static_assert((Score(5, -6, 7) - Score(10, 10, -10)).mg() == -16);
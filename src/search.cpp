@@ -1,70 +1,136 @@
 #include "search.hpp"
 #include "eval.hpp"
+#include "syzygy.hpp"
+#include "uci.hpp"
 #include "utils.hpp"
 #include <algorithm>
-#include <iostream>
 #include <chrono>
 
 using namespace chess;
 
 namespace {
+// "cp <x>" or "mate <moves>", negative when the side to move is mated
+std::string score_to_uci(int score) {
+    if (::utils::is_mate_score(score)) return "mate " + std::to_string(::utils::mate_moves(score));
+    return "cp " + std::to_string(score);
+}
+
 // Piece values used for delta pruning
 constexpr int VALS[7] = {100, 320, 330, 500, 900, 20000, 0};
 
-// Returns true if move m delivers immediate checkmate
-bool givesMate(Board b, const Move& m) {
-    b.makeMove(m);
-    Movelist replies; movegen::legalmoves(replies, b);
-    return replies.empty() && b.inCheck();
+// History bonus (and, negated, malus) for a result at `depth`
+int history_bonus(int depth) {
+    return std::min(1800, 32 * depth * depth + 64 * depth);
+}
+
+// Lazy SMP helper diversification: helper `id` searches iteration d only if
+// ((d + SKIP_PHASE[i]) / SKIP_SIZE[i]) is even, i = (id - 1) % 20. The phase
+// offsets the helpers' depths against each other and the main thread; the
+// size sets how many iterations they skip at a time.
+constexpr int SKIP_SIZE[20]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr int SKIP_PHASE[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// Stable sort by descending score. Insertion sort: the lists are short and
+// mostly in order already, and unlike std::stable_sort it needs no buffer.
+void sort_root_moves(std::vector<RootMove>::iterator first, std::vector<RootMove>::iterator last) {
+    for (auto it = first; it != last; ++it)
+        for (auto j = it; j != first && (j - 1)->score < j->score; --j) std::iter_swap(j - 1, j);
 }
 }
 
-Search::Search(size_t ttMB) : tt_(ttMB) {
+Search::Search(TranspositionTable& tt) : tt_(tt) {
     history_.clear();
-    killers_.clear();
+}
+
+void Search::setEvalCache(size_t mb, bool shared) {
+    if (shared) {
+        ownEval_.resize(0);
+        evalCache_ = &eval::shared_cache();
+    } else {
+        ownEval_.resize(mb);
+        evalCache_ = &ownEval_;
+    }
 }
 
 void Search::newGame() {
-    tt_.new_generation();
     history_.clear();
-    killers_.clear();
-    eval::clear_cache();
+    for (auto& ss : stack_) ss.killers[0] = ss.killers[1] = Move::NO_MOVE;
+    ownEval_.clear();
+    pawns_.clear();
 }
 
-bool Search::timeUp() const {
-    if (lim_.infinite) return stop_ && stop_->load(std::memory_order_relaxed);
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0_).count();
-    if (stop_ && stop_->load(std::memory_order_relaxed)) return true;
-    return elapsed >= lim_.timeMs;
+int64_t Search::elapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0_).count();
 }
 
-void Search::orderMoves(const Board& b, Movelist& ml, Move ttMove, int ply) {
-    auto scoreOf = [&](const Move& m){
-        if (m == ttMove) return 40000000;
-        if (givesMate(b, m)) return 35000000;
-        if (b.isCapture(m)) return 30000000 + mvv_lva(b, m);
-        if (killers_.is_killer(ply, m)) return 25000000;
-        return 20000000 + history_.score(m);
-    };
-    std::sort(ml.begin(), ml.end(), [&](const Move& a, const Move& c){
-        return scoreOf(a) > scoreOf(c);
-    });
+bool Search::checkTime(uint64_t n) {
+    if (lim_.infinite) {
+        nextCheck_ = UINT64_MAX;
+        return false;
+    }
+    auto now = Clock::now();
+    auto sinceLast = std::chrono::duration_cast<std::chrono::microseconds>(now - lastCheck_).count();
+    if (sinceLast < 500 && checkInterval_ < (1u << 16)) checkInterval_ *= 2;
+    else if (sinceLast > 2000 && checkInterval_ > 128) checkInterval_ /= 2;
+    lastCheck_ = now;
+    nextCheck_ = n + checkInterval_;
+
+    // The node limit is for the whole pool. Thread 0 holds it against the
+    // pool-wide count (the helpers end when it does) and reads the count
+    // again before its share of the remainder is spent.
+    if (lim_.nodes && totalNodes_) {
+        const uint64_t total = totalNodes_();
+        if (total >= lim_.nodes) return stopped_ = true;
+        nextCheck_ = std::min(nextCheck_, n + std::max<uint64_t>(1, (uint64_t)((double)(lim_.nodes - total) * n / total)));
+    }
+
+    // Pondering time counts once ponderhit arrives, which may end the search
+    // at once
+    if (pondering()) return false;
+    if (stopOnPonderhit_
+        || std::chrono::duration_cast<std::chrono::milliseconds>(now - t0_).count() >= lim_.timeMs)
+        stopped_ = true;
+    return stopped_;
+}
+
+void Search::makeMove(Board& b, const Move& m, int ply) {
+    stack_[ply].move = m;
+    stack_[ply].contHist = &history_.continuationAfter(b, m);
+    acc_[ply + 1] = acc_[ply];
+    eval::apply_move(acc_[ply + 1], b, m);
+    if (net_) net_->apply_move(stack_[ply + 1].nnue, stack_[ply].nnue, b, m);
+    b.makeMove(m);
+    tt_.prefetch(b.hash());
+    // A king move left its side to rebuild; do it here, once, rather than at
+    // every node below that evaluates
+    if (net_) net_->refresh(stack_[ply + 1].nnue, b);
+}
+
+int Search::evaluateNnue(const Board& b, int ply) {
+    int score;
+    if (evalCache_ && evalCache_->probe(b.hash(), score)) return score;
+    score = net_->evaluate(stack_[ply].nnue, b);
+    if (evalCache_) evalCache_->store(b.hash(), score);
+    return score;
 }
 
 int Search::qsearch(Board& b, int alpha, int beta, int ply) {
-    if ((nodes_++ & 0x3FF) == 0 && timeUp()) return eval::evaluate(b);
+    if (shouldStop()) return evaluate(b, ply);
+    counters_.add(stats::QS_NODES);
+    if (ply >= ::utils::MAX_PLY) return evaluate(b, ply);
 
     // If side in check, extend like a normal node
     if (b.inCheck()) {
-        Movelist evs; movegen::legalmoves(evs, b);
-        if (evs.empty()) {
+        MovePicker mp(b, stack_[ply].moves, history_, true);
+        Move m = mp.next();
+        if (m == Move::NO_MOVE) {
             // checkmate
             return -::utils::mate_score(ply);
         }
         int best = -::utils::INF;
-        for (const auto& m : evs) {
-            if (timeUp()) break;
-            b.makeMove(m);
+        for (; m != Move::NO_MOVE; m = mp.next()) {
+            if (stopped_) break;
+            makeMove(b, m, ply);
             int sc = -qsearch(b, -beta, -alpha, ply + 1);
             b.unmakeMove(m);
             if (sc > best) best = sc;
@@ -74,26 +140,16 @@ int Search::qsearch(Board& b, int alpha, int beta, int ply) {
         return best;
     }
 
-    int stand = eval::evaluate(b);
+    int stand = stack_[ply].staticEval = evaluate(b, ply);
     if (stand >= beta) return stand;
     if (stand > alpha) alpha = stand;
 
-    Movelist ml; movegen::legalmoves(ml, b);
-    // Keep only captures & promotions
-    std::vector<Move> caps; caps.reserve(ml.size());
-    for (const auto& m : ml) {
-        if (b.isCapture(m) || m.typeOf() == Move::PROMOTION) caps.push_back(m);
-    }
-    if (caps.empty()) return stand;
-
-    // MVV-LVA ordering
-    std::sort(caps.begin(), caps.end(), [&](const Move& a, const Move& c){
-        return mvv_lva(b, a) > mvv_lva(b, c);
-    });
+    // Captures & promotions, MVV-LVA ordered; SEE-losing ones are pruned
+    MovePicker mp(b, stack_[ply].moves, history_, false);
 
     int best = stand;
-    for (const auto& m : caps) {
-        if (timeUp()) break;
+    for (Move m = mp.next(); m != Move::NO_MOVE; m = mp.next()) {
+        if (stopped_) break;
         // Delta pruning: skip captures/promotions that can't raise alpha
         int gain = 0;
         if (b.isCapture(m)) {
@@ -109,7 +165,7 @@ int Search::qsearch(Board& b, int alpha, int beta, int ply) {
         }
         if (stand + gain + 50 < alpha) continue;
 
-        b.makeMove(m);
+        makeMove(b, m, ply);
         int sc = -qsearch(b, -beta, -alpha, ply + 1);
         b.unmakeMove(m);
 
@@ -120,89 +176,160 @@ int Search::qsearch(Board& b, int alpha, int beta, int ply) {
     return best;
 }
 
+template <NodeType NT>
 int Search::negamax(Board& b, int depth, int alpha, int beta, int ply) {
-    if ((nodes_++ & 0x7FF) == 0 && timeUp()) return eval::evaluate(b);
+    constexpr bool PvNode = NT == NodeType::PV;
+    SearchStack& ss = stack_[ply];
+    if (PvNode) ss.pvLen = ply;
+    if (shouldStop()) return evaluate(b, ply);
+    if (ply >= ::utils::MAX_PLY) return evaluate(b, ply);
+    counters_.add(stats::MAIN_NODES);
 
     const int alphaOrig = alpha;
 
     // TT probe
     const auto key = b.hash();
     Move ttMove = Move::NO_MOVE;
-    if (auto e = tt_.probe(key)) {
-        ttMove = Move(e->move);
-        if (e->depth >= depth) {
-            int ttScore = ::utils::from_tt(e->score, ply);
-            if (e->flag == 0 /*EXACT*/) return ttScore;
-            else if (e->flag == 1 /*LOWER*/ && ttScore > alpha) alpha = ttScore;
-            else if (e->flag == 2 /*UPPER*/ && ttScore < beta)  beta  = ttScore;
-            if (alpha >= beta) return ttScore;
+    TTEntry e;
+    counters_.add(stats::TT_PROBES);
+    if (tt_.probe(key, e)) {
+        counters_.add(stats::TT_HITS);
+        ttMove = Move(e.move);
+        // Zero-window nodes take any cutoff the stored bound allows; PV nodes
+        // search on so their scores and lines stay exact
+        if (!PvNode && e.depth >= depth) {
+            int ttScore = ::utils::from_tt(e.score, ply);
+            if (e.flag == 0 /*EXACT*/
+                || (e.flag == 1 /*LOWER*/ && ttScore >= beta)
+                || (e.flag == 2 /*UPPER*/ && ttScore <= alpha)) {
+                counters_.add(stats::TT_CUTOFFS);
+                return ttScore;
+            }
+        }
+    }
+
+    // Tablebase probe. WDL tables hold the result with best play, which is
+    // exact for a draw (cursed wins and blessed losses included) and a bound
+    // otherwise (the search may still find a faster win or a mate); kept in
+    // the TT deeper than any search would go. PV nodes that cannot cut
+    // search on within the bound.
+    int tbBest = -::utils::INF, tbMax = ::utils::INF;
+    if (tbPieces_) {
+        const int pieces = b.occ().count();
+        syzygy::WDL wdl;
+        if (pieces <= tbPieces_ && (pieces < tbPieces_ || depth >= tbProbeDepth_)
+            && syzygy::probe_wdl(b, wdl)) {
+            tbHits_.store(tbHits_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            // Cursed wins and blessed losses are draws under the 50-move
+            // rule: exact, and one point off zero to prefer the side's
+            // better case
+            const int score = wdl == syzygy::WIN  ?  ::utils::TB_WIN - ply
+                            : wdl == syzygy::LOSS ? -::utils::TB_WIN + ply : (int)wdl;
+            const uint8_t flag = wdl == syzygy::WIN ? 1 /*LOWER*/ : wdl == syzygy::LOSS ? 2 /*UPPER*/ : 0;
+            if (flag == 0 || (flag == 1 && score >= beta) || (flag == 2 && score <= alpha)) {
+                tt_.store(key, Move::NO_MOVE, std::min(depth + 6, ::utils::MAX_PLY - 1),
+                          ::utils::to_tt(score, ply), flag);
+                return score;
+            }
+            if (PvNode) {
+                if (flag == 1) alpha = std::max(alpha, tbBest = score);
+                else tbMax = score;
+            }
         }
     }
 
     bool inCheck = b.inCheck();
 
     // Futility pruning: if position looks hopeless, cut search early
-    if (!inCheck && depth <= 2) {
-        int stand = eval::evaluate(b);
+    if (!PvNode && !inCheck && depth <= 2) {
+        int stand = ss.staticEval = evaluate(b, ply);
         int margin = 125 * depth;
-        if (stand + margin <= alpha) return stand;
+        counters_.add(stats::FUTILITY_TRIES);
+        if (stand + margin <= alpha) {
+            counters_.add(stats::FUTILITY_CUTOFFS);
+            return stand;
+        }
     }
 
     if (depth <= 0) return qsearch(b, alpha, beta, ply);
 
     // Null move pruning
-    if (!inCheck && depth >= 2) {
+    if (!PvNode && !inCheck && depth >= 2) {
         uint64_t occSide = b.us(b.sideToMove()).getBits();
         uint64_t pawnsSide = b.pieces(PieceType::PAWN, b.sideToMove()).getBits();
         if ((occSide ^ pawnsSide) != 0) {
             b.makeNullMove();
+            ss.move = Move::NULL_MOVE;
+            ss.contHist = nullptr;
+            tt_.prefetch(b.hash());
+            acc_[ply + 1] = acc_[ply];
+            if (net_) stack_[ply + 1].nnue = ss.nnue;
             int R = 2 + depth / 3;
-            int score = -negamax(b, depth - 1 - R, -beta, -beta + 1, ply + 1);
+            counters_.add(stats::NULL_TRIES);
+            int score = -negamax<NodeType::NonPV>(b, depth - 1 - R, -beta, -beta + 1, ply + 1);
             b.unmakeNullMove();
-            if (score >= beta) return score;
+            if (score >= beta) {
+                counters_.add(stats::NULL_CUTOFFS);
+                return score;
+            }
         }
     }
 
-    Movelist ml; movegen::legalmoves(ml, b);
-    if (ml.empty()) {
-        if (inCheck) return -::utils::mate_score(ply);
-        return 0; // stalemate
-    }
-
     // Simple check extension
     if (inCheck) depth += 1;
 
-    orderMoves(b, ml, ttMove, ply);
+    const PieceToHistory* cont[2] = {stack_[ply - 1].contHist, ply >= 2 ? stack_[ply - 2].contHist : nullptr};
+    MovePicker mp(b, ss.moves, ttMove, ss.killers, history_, cont);
 
-    int bestScore = -::utils::INF;
+    int bestScore = tbBest;
     Move bestMove = Move::NO_MOVE;
     int movesSearched = 0;
+    // Searched moves, for the history maluses once one of them is best
+    Move quietsTried[64], capturesTried[32];
+    int nQuiets = 0, nCaptures = 0;
+
+    for (Move m = mp.next(); m != Move::NO_MOVE; m = mp.next()) {
+        if (stopped_) return 0; // result is discarded
+        const bool capture = b.isCapture(m);
+        const bool quiet = !capture && m.typeOf() != Move::PROMOTION;
+
+        // SEE pruning: at shallow depth skip moves that lose material beyond
+        // a depth-scaled margin
+        if (!inCheck && movesSearched > 0 && depth <= 3 && !::utils::is_mate_score(bestScore)) {
+            int margin = quiet ? -30 * depth * depth : -100 * depth;
+            if (!see(b, m, margin)) continue;
+        }
 
-    for (const auto& m : ml) {
-        if (timeUp()) break;
-        b.makeMove(m);
-        // Late-move reduction (super light)
-        int subDepth = depth - 1;
-        if (subDepth > 0 && movesSearched >= 4 && !b.isCapture(m) && m.typeOf()!=Move::PROMOTION) {
-            subDepth -= 1;
+        // Late-move reduction (super light): quiets and losing captures only
+        int reduction = 0;
+        if (depth >= 2 && movesSearched >= 4 && !inCheck && (quiet || (capture && !see(b, m, 0)))) {
+            reduction = 1;
         }
+
+        makeMove(b, m, ply);
+        if (PvNode) stack_[ply + 1].pvLen = ply + 1;
+        int subDepth = depth - 1;
         int sc;
-        if (movesSearched == 0) {
-            sc = -negamax(b, subDepth, -beta, -alpha, ply + 1);
+        if (PvNode && movesSearched == 0) {
+            sc = -negamax<NodeType::PV>(b, subDepth, -beta, -alpha, ply + 1);
         } else {
-            sc = -negamax(b, subDepth, -alpha - 1, -alpha, ply + 1);
-            if (sc > alpha) {
-                sc = -negamax(b, subDepth, -beta, -alpha, ply + 1);
+            if (reduction) counters_.add(stats::LMR_SEARCHES);
+            sc = -negamax<NodeType::NonPV>(b, subDepth - reduction, -alpha - 1, -alpha, ply + 1);
+            if (sc > alpha && reduction) {
+                counters_.add(stats::LMR_RESEARCHES);
+                sc = -negamax<NodeType::NonPV>(b, subDepth, -alpha - 1, -alpha, ply + 1);
+            }
+            if (PvNode && sc > alpha && sc < beta) {
+                sc = -negamax<NodeType::PV>(b, subDepth, -beta, -alpha, ply + 1);
             }
         }
         b.unmakeMove(m);
 
-        if (::utils::is_mate_score(sc)) {
-            history_.bonus(m, 4000);
-            killers_.push(ply, m);
-        }
+        if (::utils::is_mate_score(sc)) ss.pushKiller(m);
 
         movesSearched++;
+        if (quiet && nQuiets < 64) quietsTried[nQuiets++] = m;
+        else if (capture && nCaptures < 32) capturesTried[nCaptures++] = m;
 
         if (sc > bestScore) {
             bestScore = sc;
@@ -210,22 +337,24 @@ int Search::negamax(Board& b, int depth, int alpha, int beta, int ply) {
         }
         if (sc > alpha) {
             alpha = sc;
-            // history / killer updates for quiets
-            if (!b.isCapture(m) && m.typeOf()!=Move::PROMOTION) {
-                history_.bonus(m, std::min(2000, 100 + depth*depth));
-                killers_.push(ply, m);
-            }
+            if (PvNode) updatePV(ply, m);
+            if (quiet) ss.pushKiller(m);
         }
         if (alpha >= beta) {
-            // history bonus on fail-high
-            if (!b.isCapture(m) && m.typeOf()!=Move::PROMOTION) {
-                history_.bonus(m, std::min(4000, 200 + depth*depth));
-                killers_.push(ply, m);
-            }
+            counters_.add(stats::FAIL_HIGHS);
+            if (movesSearched == 1) counters_.add(stats::FAIL_HIGHS_FIRST);
             break;
         }
     }
 
+    if (movesSearched == 0) {
+        if (inCheck) return -::utils::mate_score(ply);
+        return 0; // stalemate
+    }
+    if (bestScore > alphaOrig && bestMove != Move::NO_MOVE)
+        updateHistories(b, ply, depth, bestMove, quietsTried, nQuiets, capturesTried, nCaptures);
+    if (PvNode) bestScore = std::min(bestScore, tbMax);
+
     // Store TT
     uint8_t flag = 0;
     if      (bestScore <= alphaOrig) flag = 2; // UPPER
@@ -236,102 +365,267 @@ int Search::negamax(Board& b, int depth, int alpha, int beta, int ply) {
     return bestScore;
 }
 
+// Root node: every legal move from rootMoves_[pvIdx_] on is searched (no
+// pruning or reductions) in the order of the previous iteration, recording
+// nodes and score per move. Moves that do not raise alpha are scored -INF, so
+// after the stable sort the best move leads and the rest keep their order.
+int Search::searchRoot(Board& b, int depth, int alpha, int beta) {
+    const int alphaOrig = alpha;
+    const bool inCheck = b.inCheck();
+    if (inCheck) depth += 1;
+
+    const auto first = rootMoves_.begin() + pvIdx_;
+    for (auto it = first; it != rootMoves_.end(); ++it) it->score = -::utils::INF;
+
+    int bestScore = -::utils::INF;
+    Move bestMove = Move::NO_MOVE;
+    int movesSearched = 0;
+    Move quietsTried[64], capturesTried[32];
+    int nQuiets = 0, nCaptures = 0;
+
+    for (auto it = first; it != rootMoves_.end(); ++it) {
+        RootMove& rm = *it;
+        const Move m = rm.move;
+        const bool capture = b.isCapture(m);
+        const bool quiet = !capture && m.typeOf() != Move::PROMOTION;
+        const uint64_t nodesBefore = nodes();
+
+        makeMove(b, m, 0);
+        stack_[1].pvLen = 1;
+        int sc;
+        if (movesSearched == 0) {
+            sc = -negamax<NodeType::PV>(b, depth - 1, -beta, -alpha, 1);
+        } else {
+            sc = -negamax<NodeType::NonPV>(b, depth - 1, -alpha - 1, -alpha, 1);
+            if (sc > alpha && sc < beta)
+                sc = -negamax<NodeType::PV>(b, depth - 1, -beta, -alpha, 1);
+        }
+        b.unmakeMove(m);
+        rm.nodes += nodes() - nodesBefore;
+        if (stopped_) break;
+
+        movesSearched++;
+        if (quiet && nQuiets < 64) quietsTried[nQuiets++] = m;
+        else if (capture && nCaptures < 32) capturesTried[nCaptures++] = m;
+        if (movesSearched == 1 || sc > alpha) {
+            rm.score = sc;
+            rm.pv.assign(1, m);
+            rm.pv.insert(rm.pv.end(), &stack_[1].pv[1], &stack_[1].pv[stack_[1].pvLen]);
+        }
+        if (sc > bestScore) {
+            bestScore = sc;
+            bestMove = m;
+        }
+        if (sc > alpha) alpha = sc;
+        if (alpha >= beta) {
+            if (quiet) stack_[0].pushKiller(m);
+            break;
+        }
+    }
+    if (bestScore > alphaOrig && !stopped_)
+        updateHistories(b, 0, depth, bestMove, quietsTried, nQuiets, capturesTried, nCaptures);
+
+    sort_root_moves(first, rootMoves_.end());
+
+    // Only the full root search (the first line) describes the position
+    if (pvIdx_ == 0 && movesSearched > 0 && !stopped_) {
+        uint8_t flag = bestScore <= alphaOrig ? 2 : bestScore >= beta ? 1 : 0;
+        tt_.store(b.hash(), bestMove.move(), depth, ::utils::to_tt(bestScore, 0), flag);
+    }
+    return bestScore;
+}
+
 SearchResult Search::go(const Board& root, const SearchLimits& lim) {
     lim_ = lim;
-    nodes_ = 0;
-    t0_ = Clock::now();
-
+    nodes_.store(0, std::memory_order_relaxed);
+    tbHits_.store(0, std::memory_order_relaxed);
+    tbPieces_ = syzygy::max_pieces();
+    counters_.clear();
+    t0_ = lastCheck_ = Clock::now();
+    stopped_ = false;
+    stopOnPonderhit_ = false;
+    checkInterval_ = 1024;
+    // A small pool-wide node budget is checked early, before the helpers
+    // alone can spend it
+    nextCheck_ = lim.nodes && totalNodes_ ? std::clamp<uint64_t>(lim.nodes / 64, 1, checkInterval_)
+                                          : checkInterval_;
+    tm_.start(lim.infinite ? 0 : std::min(lim.softMs, lim.timeMs), lim.timeMs);
+
+    // The one copy of the root for this search: every root search unmakes
+    // its moves, even when stopped, so it leaves the position as it found it
+    Board pos = root;
     SearchResult res{};
-    Movelist rootMoves; movegen::legalmoves(rootMoves, root);
-    if (rootMoves.empty()) {
+    {
+        // Initial root order from the usual move ordering (TT move first)
+        TTEntry e;
+        Move ttMove = tt_.probe(pos.hash(), e) ? Move(e.move) : Move(Move::NO_MOVE);
+        const PieceToHistory* noCont[2] = {nullptr, nullptr};
+        MovePicker mp(pos, stack_[0].moves, ttMove, stack_[0].killers, history_, noCont);
+        // Entries are reused so their PV vectors keep their capacity
+        size_t n = 0;
+        for (Move m = mp.next(); m != Move::NO_MOVE; m = mp.next(), ++n) {
+            if (n == rootMoves_.size()) rootMoves_.emplace_back();
+            RootMove& rm = rootMoves_[n];
+            rm.move = m;
+            rm.score = rm.prevScore = -::utils::INF;
+            rm.nodes = 0;
+            rm.pv.clear();
+        }
+        rootMoves_.resize(n);
+    }
+    if (rootMoves_.empty()) {
         res.best = Move::NO_MOVE;
         res.bestScore = 0;
+        searchMs_ = elapsedMs();
         return res;
     }
 
+    // Root in the tablebases: search only the moves that keep its DTZ
+    // outcome. They already make progress (or hold the draw), so the WDL
+    // probes below would add nothing.
+    std::vector<Move> tbMoves;
+    syzygy::WDL rootWdl;
+    if (tbPieces_ && syzygy::probe_root(root, tbMoves, rootWdl)) {
+        std::erase_if(rootMoves_, [&](const RootMove& rm) {
+            return std::find(tbMoves.begin(), tbMoves.end(), rm.move) == tbMoves.end();
+        });
+        tbHits_.store(rootMoves_.size(), std::memory_order_relaxed);
+        tbPieces_ = 0;
+    }
+
     int maxDepth = (lim.depth > 0 ? lim.depth : 64);
-    Move best = rootMoves.front();
+    Move best = rootMoves_.front().move;
     int  bestScore = -::utils::INF;
     int  prevScore = 0;
+    const int multiPV = std::clamp(lim.multiPV, 1, (int)rootMoves_.size());
 
     // Iterative deepening
     for (int d = 1; d <= maxDepth; ++d) {
-        if (timeUp()) break;
+        if (stopped_) break;
+        if (id_ > 0 && d > 1 && d < maxDepth) {
+            int i = (id_ - 1) % 20;
+            if (((d + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2) continue;
+        }
 
-        int alpha = -::utils::INF;
-        int beta  = ::utils::INF;
+        // One root search per MultiPV line, each excluding the moves of the
+        // lines before it; TT, history and killers carry over between them
+        for (auto& rm : rootMoves_) rm.prevScore = rm.score;
         int score = 0;
-        if (d > 1) {
-            int window = 25;
-            alpha = prevScore - window;
-            beta  = prevScore + window;
-            Board pos = root;
-            score = negamax(pos, d, alpha, beta, 0);
-            if (!timeUp() && (score <= alpha || score >= beta)) {
-                alpha = -::utils::INF;
-                beta  = ::utils::INF;
-                pos = root;
-                score = negamax(pos, d, alpha, beta, 0);
+        for (pvIdx_ = 0; pvIdx_ < multiPV && !stopped_; ++pvIdx_) {
+            int prev = pvIdx_ == 0 ? prevScore : rootMoves_[pvIdx_].prevScore;
+            int alpha = -::utils::INF;
+            int beta  = ::utils::INF;
+            acc_[0] = eval::accumulate(pos);
+            if (net_) {
+                stack_[0].nnue.dirty[0] = stack_[0].nnue.dirty[1] = true;
+                net_->refresh(stack_[0].nnue, pos);
             }
-        } else {
-            Board pos = root;
-            score = negamax(pos, d, alpha, beta, 0);
+            if (d > 1 && prev > -::utils::INF) {
+                int window = 25;
+                alpha = prev - window;
+                beta  = prev + window;
+                score = searchRoot(pos, d, alpha, beta);
+                if (!stopped_ && (score <= alpha || score >= beta)) {
+                    alpha = -::utils::INF;
+                    beta  = ::utils::INF;
+                    score = searchRoot(pos, d, alpha, beta);
+                }
+            } else {
+                score = searchRoot(pos, d, alpha, beta);
+            }
+            sort_root_moves(rootMoves_.begin(), rootMoves_.begin() + pvIdx_ + 1);
         }
+        // A later line may have outscored the first and been sorted ahead of
+        // it; the front move is the best and its score goes with it
+        score = rootMoves_.front().score;
 
-        bool interrupted = timeUp();
+        bool interrupted = stopped_;
 
-        // Extract PV from TT regardless of interruption so we keep the best
-        auto pv = extractPV(root);
-        if (!pv.empty()) best = pv.front();
+        // Even a partial iteration leaves the best move it found in front
+        best = rootMoves_.front().move;
         if (interrupted) break;
 
         bestScore = score;
         prevScore = score;
+        res.depth = d;
+        counters_.iteration(d, nodes());
+
+        // Only the main thread manages time; helpers run until it stops them
+        bool enough = false;
+        if (id_ == 0 && !lim_.infinite) {
+            uint64_t bestNodes = 0;
+            for (const auto& rm : rootMoves_)
+                if (rm.move == best) bestNodes = rm.nodes;
+            tm_.update(best.move(), score, (double)bestNodes / (double)std::max<uint64_t>(1, nodes()));
+            enough = tm_.stopAfterIteration(elapsedMs());
+            if (enough && pondering()) {
+                stopOnPonderhit_ = true;
+                enough = false;
+            }
+        }
+        if (id_ != 0) continue;
+        if (lim_.quiet || !out_) { if (enough) break; continue; }
 
         auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0_).count();
-        // UCI info
-        std::cout << "info depth " << d
-                  << " score cp " << bestScore
-                  << " time " << ms
-                  << " nodes " << nodes_
-                  << " pv ";
-        for (const auto& m : pv) {
-            auto f = m.from(), t = m.to();
-            std::string s;
-            s += char('a'+f.file()); s += char('1'+f.rank());
-            s += char('a'+t.file()); s += char('1'+t.rank());
-            if (m.typeOf()==Move::PROMOTION) {
-                auto pt = m.promotionType();
-                char c = 'q';
-                if (pt==PieceType::KNIGHT) c = 'n';
-                else if (pt==PieceType::BISHOP) c = 'b';
-                else if (pt==PieceType::ROOK) c = 'r';
-                s += c;
-            }
-            std::cout << s << ' ';
+        uint64_t nodes = totalNodes_ ? totalNodes_() : this->nodes();
+        uint64_t tbHits = totalTbHits_ ? totalTbHits_() : this->tbHits();
+        // UCI info, one line per MultiPV line
+        for (int i = 0; i < multiPV; ++i) {
+            const RootMove& rm = rootMoves_[i];
+            output::Line line;
+            line << "info depth " << d
+                 << " multipv " << (i + 1)
+                 << " score " << score_to_uci(rm.score)
+                 << " time " << ms
+                 << " nodes " << nodes
+                 << " nps " << nodes * 1000 / (uint64_t)std::max<int64_t>(1, ms)
+                 << " tbhits " << tbHits
+                 << " pv ";
+            for (const auto& m : rm.pv)
+                line << UciDriver::move_to_uci(m) << ' ';
+            line << '\n';
+            out_->push(line.view());
         }
-        std::cout << "\n" << std::flush;
+        if (enough) break;
     }
 
+    searchMs_ = elapsedMs();
     res.best = best;
     res.bestScore = bestScore;
+    for (const auto& rm : rootMoves_) {
+        if (rm.move != best) continue;
+        res.pv = rm.pv;
+        if (rm.pv.size() > 1) res.ponder = rm.pv[1];
+    }
     return res;
 }
 
-std::vector<Move> Search::extractPV(const Board& root) {
-    std::vector<Move> pv;
-    Board b = root;
-    for (int i=0; i<64; ++i) {
-        auto e = tt_.probe(b.hash());
-        if (!e || e->move == Move::NO_MOVE) break;
-        Move m = Move(e->move);
-        // validate m is legal in this position
-        Movelist ml; movegen::legalmoves(ml, b);
-        bool found = false;
-        for (auto& lm : ml) if (lm.move()==m.move()) { found = true; break; }
-        if (!found) break;
-        pv.push_back(m);
-        b.makeMove(m);
+void Search::updateHistories(const Board& b, int ply, int depth, Move best,
+                             const Move* quiets, int nQuiets, const Move* captures, int nCaptures) {
+    const int bonus = history_bonus(depth);
+    if (b.isCapture(best)) {
+        History::update(history_.captured(b, best), bonus);
+    } else if (best.typeOf() != Move::PROMOTION) {
+        updateQuietHistory(b, ply, best, bonus);
+        for (int i = 0; i < nQuiets; ++i)
+            if (quiets[i] != best) updateQuietHistory(b, ply, quiets[i], -bonus);
     }
-    return pv;
+    // Captures searched before the best move failed, whatever kind it was
+    for (int i = 0; i < nCaptures; ++i)
+        if (captures[i] != best) History::update(history_.captured(b, captures[i]), -bonus);
+}
+
+void Search::updateQuietHistory(const Board& b, int ply, Move m, int bonus) {
+    History::update(history_.quiet(b, m), bonus);
+    const int pc = (int)b.at(m.from()), to = m.to().index();
+    for (int back = 1; back <= 2 && back <= ply; ++back)
+        if (PieceToHistory* cont = stack_[ply - back].contHist) History::update((*cont)[pc][to], bonus);
+}
+
+void Search::updatePV(int ply, const Move& m) {
+    SearchStack& ss = stack_[ply];
+    const SearchStack& child = stack_[ply + 1];
+    ss.pv[ply] = m;
+    for (int i = ply + 1; i < child.pvLen; ++i) ss.pv[i] = child.pv[i];
+    ss.pvLen = std::max(ply + 1, child.pvLen);
 }
@@ -3,47 +3,192 @@
 #include <cstdint>
 #include <vector>
 #include <chrono>
+#include <functional>
 #include <optional>
 #include "external/chess/include/chess.hpp"
 #include "tt.hpp"
 #include "move_order.hpp"
+#include "eval.hpp"
+#include "nnue.hpp"
+#include "output.hpp"
+#include "stats.hpp"
+#include "timeman.hpp"
+#include "utils.hpp"
 
 struct SearchLimits {
-    int timeMs = 1000;
+    int timeMs = 1000;  // hard limit: the search is aborted here
+    int softMs = 0;     // clock games: optimum time, scaled by the TimeManager; 0 = off
     int depth  = 0;     // 0=auto
+    uint64_t nodes = 0; // 0=unlimited; counted over all threads
+    int multiPV = 1;    // number of best lines to report
     bool infinite = false;
+    bool ponder = false; // go ponder: no time checks until ponderhit
+    bool quiet = false; // no info output (bench)
 };
 
 struct SearchResult {
     chess::Move best = chess::Move::NO_MOVE;
     int bestScore = 0;
+    int depth = 0;      // last fully searched iteration
+    chess::Move ponder = chess::Move::NO_MOVE; // expected reply, from the PV
+    std::vector<chess::Move> pv;
+};
+
+// Below the root (see Search::searchRoot) nodes are either on the PV, with an
+// open window and exact scores, or zero-window nodes, which alone take TT
+// cutoffs and forward pruning
+enum class NodeType { PV, NonPV };
+
+// Root move with its score from the current iteration (-INF unless it raised
+// alpha), its principal variation and the nodes spent below it over the
+// whole search
+struct RootMove {
+    chess::Move move;
+    int score = -::utils::INF;
+    int prevScore = -::utils::INF; // score of the previous iteration
+    uint64_t nodes = 0;
+    std::vector<chess::Move> pv;
+};
+
+// Per-ply state of the node being searched at that ply, preallocated in each
+// Search so that nodes below the root allocate nothing
+struct SearchStack {
+    int staticEval = 0;                      // set once the node evaluated itself
+    chess::Move move = chess::Move::NO_MOVE; // move being searched from this node
+    // Quiet moves that caused cutoffs at this ply; kept across searches
+    chess::Move killers[2] = {chess::Move::NO_MOVE, chess::Move::NO_MOVE};
+    MoveBuffer moves;                        // storage of the node's MovePicker
+    // NNUE accumulator of the node's position, in step with acc_ while the
+    // search has a network; never dirty below the root
+    nnue::Accumulator nnue;
+    // Continuation history following `move`; null after a null move
+    PieceToHistory* contHist = nullptr;
+    // pv[ply..pvLen) is the line found below this node; written in PV nodes only
+    int pvLen = 0;
+    chess::Move pv[::utils::MAX_PLY + 1];
+
+    void pushKiller(chess::Move m) {
+        if (m == killers[0] || m == killers[1]) return;
+        killers[1] = killers[0];
+        killers[0] = m;
+    }
 };
 
 class Search {
 public:
-    explicit Search(size_t ttMB = 64);
+    explicit Search(TranspositionTable& tt);
 
     void setStopFlag(std::atomic<bool>* f) { stop_ = f; }
+    // Where thread 0 queues its `info` lines (not owned); none when null
+    void setOutput(output::Queue* out) { out_ = out; }
+    // Cleared by ponderhit; while set the clock is not checked
+    void setPonderFlag(const std::atomic<bool>* f) { ponder_ = f; }
+    // Lazy SMP role. Thread 0 prints `info` lines, reporting `totalNodes()`
+    // and `totalTbHits()` when given (the pool-wide counts); other ids are
+    // silent helpers that skip iterations in a per-id pattern.
+    void setThreadId(int id, std::function<uint64_t()> totalNodes = {},
+                     std::function<uint64_t()> totalTbHits = {}) {
+        id_ = id;
+        totalNodes_ = std::move(totalNodes);
+        totalTbHits_ = std::move(totalTbHits);
+    }
+    // Use a private eval cache of `mb` megabytes, or the shared one
+    void setEvalCache(size_t mb, bool shared);
+    // Evaluate with `net` (not owned), or the classical eval when null
+    void setNetwork(const nnue::Network* net) { net_ = net; }
+    // Remaining depth from which positions with as many pieces as the largest
+    // loaded tablebases are probed; smaller endgames are probed at any depth
+    void setSyzygyProbeDepth(int depth) { tbProbeDepth_ = depth; }
     void newGame();
 
     SearchResult go(const chess::Board& root, const SearchLimits& lim);
 
+    const eval::PawnTable& pawnTable() const { return pawns_; }
+    // Nodes of the current/last search; safe to read from other threads
+    uint64_t nodes() const { return nodes_.load(std::memory_order_relaxed); }
+    uint64_t tbHits() const { return tbHits_.load(std::memory_order_relaxed); }
+    // Counters and duration of the last search; read once it is over
+    const stats::Counters& counters() const { return counters_; }
+    int64_t searchMs() const { return searchMs_; }
+
 private:
+    int  searchRoot(chess::Board& b, int depth, int alpha, int beta);
+    template <NodeType NT>
     int  negamax(chess::Board& b, int depth, int alpha, int beta, int ply);
     int  qsearch(chess::Board& b, int alpha, int beta, int ply);
-    void orderMoves(const chess::Board& b, chess::Movelist& ml, chess::Move ttMove, int ply);
-    bool timeUp() const;
+    // Count a node and report whether the search must unwind. Only the stop
+    // flag and node limit are looked at per node; the clock is read every
+    // checkInterval_ nodes, an interval retuned at each read so reads land
+    // roughly a millisecond apart whatever the speed.
+    bool shouldStop() {
+        uint64_t n = nodes_.load(std::memory_order_relaxed) + 1;
+        nodes_.store(n, std::memory_order_relaxed);
+        if (stopped_) return true;
+        if ((stop_ && stop_->load(std::memory_order_relaxed)) || (lim_.nodes && n >= lim_.nodes))
+            return stopped_ = true;
+        return n >= nextCheck_ && checkTime(n);
+    }
+    bool checkTime(uint64_t n);
+    int64_t elapsedMs() const;
+    // Make/unmake `m` at `ply`, keeping the eval accumulators of ply + 1 in step
+    void makeMove(chess::Board& b, const chess::Move& m, int ply);
+    int  evaluate(const chess::Board& b, int ply) {
+        if constexpr (stats::ENABLED) {
+            // eval::evaluate() probes the cache itself; repeat the probe to count it
+            int cached;
+            counters_.add(stats::EVAL_PROBES);
+            if (evalCache_ && evalCache_->probe(b.hash(), cached)) {
+                counters_.add(stats::EVAL_HITS);
+                return cached;
+            }
+        }
+        if (net_) return evaluateNnue(b, ply);
+        return eval::evaluate(b, acc_[ply], evalCache_, &pawns_);
+    }
+    int  evaluateNnue(const chess::Board& b, int ply);
 
-    std::vector<chess::Move> extractPV(const chess::Board& root);
+    // The PV of `ply` becomes m followed by the child line of ply + 1
+    void updatePV(int ply, const chess::Move& m);
+    // `best` raised alpha at `ply` after the listed moves were searched: it
+    // gets a history bonus, the other quiets (if it is quiet) and captures a malus
+    void updateHistories(const chess::Board& b, int ply, int depth, chess::Move best,
+                         const chess::Move* quiets, int nQuiets,
+                         const chess::Move* captures, int nCaptures);
+    // Butterfly and continuation history of quiet `m` at `ply`
+    void updateQuietHistory(const chess::Board& b, int ply, chess::Move m, int bonus);
 
 private:
-    TranspositionTable tt_;
+    TranspositionTable& tt_;
     History history_;
-    Killers killers_;
+    SearchStack stack_[::utils::MAX_PLY + 2];
+    eval::EvalCache ownEval_;
+    eval::EvalCache* evalCache_ = &ownEval_;
+    eval::PawnTable pawns_;
+    eval::Accumulator acc_[::utils::MAX_PLY + 1];
+    const nnue::Network* net_ = nullptr;
     std::atomic<bool>* stop_ = nullptr;
+    output::Queue* out_ = nullptr;
+    const std::atomic<bool>* ponder_ = nullptr;
+    bool stopOnPonderhit_ = false; // time ran out while pondering
+    bool pondering() const { return ponder_ && ponder_->load(std::memory_order_relaxed); }
 
     using Clock = std::chrono::steady_clock;
     Clock::time_point t0_;
+    Clock::time_point lastCheck_;
     SearchLimits lim_;
-    uint64_t nodes_ = 0;
+    bool stopped_ = false;      // a limit was hit; sticky for this search
+    uint64_t nextCheck_ = 0;    // node count of the next clock read
+    uint64_t checkInterval_ = 1024;
+    TimeManager tm_;
+    std::vector<RootMove> rootMoves_;
+    int pvIdx_ = 0; // MultiPV line being searched; earlier root moves are excluded
+    std::atomic<uint64_t> nodes_{0}; // single writer: this thread
+    std::atomic<uint64_t> tbHits_{0}; // likewise
+    int tbPieces_ = 0;      // probe positions with at most this many pieces; 0 = off
+    int tbProbeDepth_ = 1;
+    stats::Counters counters_;
+    int64_t searchMs_ = 0;
+    int id_ = 0;
+    std::function<uint64_t()> totalNodes_;
+    std::function<uint64_t()> totalTbHits_;
 };
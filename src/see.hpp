@@ -0,0 +1,83 @@
+#pragma once
+#include "external/chess/include/chess.hpp"
+#include <cstdint>
+
+// Static exchange evaluation
+namespace see_detail {
+
+inline constexpr int VALUE[7] = {100, 320, 330, 500, 900, 20000, 0}; // P N B R Q K NONE
+
+inline uint64_t attackers_to(const chess::Board& b, chess::Square sq, uint64_t occ) {
+    using namespace chess;
+    uint64_t bq = (b.pieces(PieceType::BISHOP) | b.pieces(PieceType::QUEEN)).getBits();
+    uint64_t rq = (b.pieces(PieceType::ROOK) | b.pieces(PieceType::QUEEN)).getBits();
+    return (attacks::pawn(Color::BLACK, sq).getBits() & b.pieces(PieceType::PAWN, Color::WHITE).getBits())
+         | (attacks::pawn(Color::WHITE, sq).getBits() & b.pieces(PieceType::PAWN, Color::BLACK).getBits())
+         | (attacks::knight(sq).getBits() & b.pieces(PieceType::KNIGHT).getBits())
+         | (attacks::bishop(sq, occ).getBits() & bq)
+         | (attacks::rook(sq, occ).getBits() & rq)
+         | (attacks::king(sq).getBits() & b.pieces(PieceType::KING).getBits());
+}
+
+} // namespace see_detail
+
+// True if the exchange sequence started by `m` on its target square gains at
+// least `threshold` centipawns for the side to move. Both sides recapture with
+// their least valuable attacker and may stop at any point; x-ray attackers
+// behind moved sliders are revealed, pins are ignored. Castling, en passant and
+// promotions are scored as an even trade.
+inline bool see(const chess::Board& b, chess::Move m, int threshold = 0) {
+    using namespace chess;
+    using see_detail::VALUE;
+
+    if (m.typeOf() != Move::NORMAL) return 0 >= threshold;
+
+    Square from = m.from(), to = m.to();
+    int swap = VALUE[(int)b.at(to).type()] - threshold;
+    if (swap < 0) return false;
+    swap = VALUE[(int)b.at(from).type()] - swap;
+    if (swap <= 0) return true;
+
+    uint64_t occ = b.occ().getBits() ^ (1ULL << from.index()) ^ (1ULL << to.index());
+    uint64_t attackers = see_detail::attackers_to(b, to, occ);
+    uint64_t bq = (b.pieces(PieceType::BISHOP) | b.pieces(PieceType::QUEEN)).getBits();
+    uint64_t rq = (b.pieces(PieceType::ROOK) | b.pieces(PieceType::QUEEN)).getBits();
+
+    Color stm = b.sideToMove();
+    int res = 1;
+    while (true) {
+        stm = ~stm;
+        attackers &= occ;
+        uint64_t stmAttackers = attackers & b.us(stm).getBits();
+        if (!stmAttackers) break;
+        res ^= 1;
+
+        // Least valuable attacker
+        uint64_t bb;
+        if ((bb = stmAttackers & b.pieces(PieceType::PAWN).getBits())) {
+            if ((swap = VALUE[0] - swap) < res) break;
+            occ ^= bb & -bb;
+            attackers |= attacks::bishop(to, occ).getBits() & bq;
+        } else if ((bb = stmAttackers & b.pieces(PieceType::KNIGHT).getBits())) {
+            if ((swap = VALUE[1] - swap) < res) break;
+            occ ^= bb & -bb;
+        } else if ((bb = stmAttackers & b.pieces(PieceType::BISHOP).getBits())) {
+            if ((swap = VALUE[2] - swap) < res) break;
+            occ ^= bb & -bb;
+            attackers |= attacks::bishop(to, occ).getBits() & bq;
+        } else if ((bb = stmAttackers & b.pieces(PieceType::ROOK).getBits())) {
+            if ((swap = VALUE[3] - swap) < res) break;
+            occ ^= bb & -bb;
+            attackers |= attacks::rook(to, occ).getBits() & rq;
+        } else if ((bb = stmAttackers & b.pieces(PieceType::QUEEN).getBits())) {
+            if ((swap = VALUE[4] - swap) < res) break;
+            occ ^= bb & -bb;
+            attackers |= (attacks::bishop(to, occ).getBits() & bq)
+                       | (attacks::rook(to, occ).getBits() & rq);
+        } else {
+            // King: may only capture if the opponent has no attackers left
+            return (attackers & ~b.us(stm).getBits()) ? (res ^ 1) : res;
+        }
+    }
+    return res;
+}
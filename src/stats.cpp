@@ -0,0 +1,85 @@
+#include "stats.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+namespace {
+
+double pct(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+} // namespace
+
+namespace stats {
+
+Counters& Counters::operator+=(const Counters& o) {
+    for (int i = 0; i < COUNTER_NB; ++i) value[i] += o.value[i];
+    return *this;
+}
+
+void print(std::ostream& os, const std::vector<ThreadReport>& threads) {
+    char buf[256];
+    uint64_t nodes = 0;
+    int64_t ms = 0;
+    for (const auto& t : threads) {
+        std::snprintf(buf, sizeof(buf), "info string stats thread %d nodes %llu nps %llu pawnhash %.1f%%\n",
+                      t.id, (unsigned long long)t.nodes,
+                      (unsigned long long)(t.nodes * 1000 / (uint64_t)std::max<int64_t>(1, t.ms)),
+                      100.0 * t.pawnHitRate);
+        os << buf;
+        nodes += t.nodes;
+        ms = std::max(ms, t.ms);
+    }
+    std::snprintf(buf, sizeof(buf), "info string stats total nodes %llu nps %llu\n",
+                  (unsigned long long)nodes, (unsigned long long)(nodes * 1000 / (uint64_t)std::max<int64_t>(1, ms)));
+    os << buf;
+
+    if constexpr (!ENABLED) {
+        os << "info string stats counters off, build with -DMINERVA_STATS (./build.sh stats)\n" << std::flush;
+        return;
+    }
+
+    Counters sum;
+    for (const auto& t : threads)
+        if (t.counters) sum += *t.counters;
+    const uint64_t* v = sum.value;
+
+    std::snprintf(buf, sizeof(buf), "info string stats tt probes %llu hit %.1f%% cutoff %.1f%%\n",
+                  (unsigned long long)v[TT_PROBES], pct(v[TT_HITS], v[TT_PROBES]), pct(v[TT_CUTOFFS], v[TT_PROBES]));
+    os << buf;
+    std::snprintf(buf, sizeof(buf), "info string stats evalcache probes %llu hit %.1f%%\n",
+                  (unsigned long long)v[EVAL_PROBES], pct(v[EVAL_HITS], v[EVAL_PROBES]));
+    os << buf;
+    std::snprintf(buf, sizeof(buf), "info string stats nodes main %llu qsearch %llu (%.1f%%)\n",
+                  (unsigned long long)v[MAIN_NODES], (unsigned long long)v[QS_NODES],
+                  pct(v[QS_NODES], v[MAIN_NODES] + v[QS_NODES]));
+    os << buf;
+    std::snprintf(buf, sizeof(buf),
+                  "info string stats nullmove %llu cutoff %.1f%% futility %llu cutoff %.1f%%\n",
+                  (unsigned long long)v[NULL_TRIES], pct(v[NULL_CUTOFFS], v[NULL_TRIES]),
+                  (unsigned long long)v[FUTILITY_TRIES], pct(v[FUTILITY_CUTOFFS], v[FUTILITY_TRIES]));
+    os << buf;
+    std::snprintf(buf, sizeof(buf),
+                  "info string stats failhigh %llu first %.1f%% lmr %llu research %.1f%%\n",
+                  (unsigned long long)v[FAIL_HIGHS], pct(v[FAIL_HIGHS_FIRST], v[FAIL_HIGHS]),
+                  (unsigned long long)v[LMR_SEARCHES], pct(v[LMR_RESEARCHES], v[LMR_SEARCHES]));
+    os << buf;
+
+    // Effective branching factor: cost of iteration d over that of d - 1
+    if (!threads.empty() && threads.front().counters) {
+        const uint64_t* it = threads.front().counters->iterationNodes;
+        auto cost = [it](int d) { return it[d] - (d > 1 ? it[d - 1] : 0); };
+        std::string line = "info string stats ebf";
+        for (int d = 2; d < ::utils::MAX_PLY && it[d]; ++d) {
+            std::snprintf(buf, sizeof(buf), " %d:%.2f", d,
+                          (double)cost(d) / (double)std::max<uint64_t>(1, cost(d - 1)));
+            line += buf;
+        }
+        os << line << "\n";
+    }
+    os << std::flush;
+}
+
+} // namespace stats
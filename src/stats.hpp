@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include "utils.hpp"
+
+// Search instrumentation. The counters are compiled in with -DMINERVA_STATS
+// (./build.sh stats); otherwise add() and iteration() are empty and the
+// search does not change. Each Search owns one Counters and is its only
+// writer, so nothing here is atomic: read them once the search is over.
+namespace stats {
+
+#if defined(MINERVA_STATS)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+enum Counter : int {
+    TT_PROBES, TT_HITS, TT_CUTOFFS,
+    EVAL_PROBES, EVAL_HITS,
+    MAIN_NODES, QS_NODES,
+    NULL_TRIES, NULL_CUTOFFS,
+    FUTILITY_TRIES, FUTILITY_CUTOFFS,
+    FAIL_HIGHS, FAIL_HIGHS_FIRST,  // beta cutoffs, and those by the first move
+    LMR_SEARCHES, LMR_RESEARCHES,  // reduced searches, and those redone at full depth
+    COUNTER_NB
+};
+
+struct Counters {
+    uint64_t value[COUNTER_NB] = {};
+    // Nodes searched when iteration d completed; 0 = not completed
+    uint64_t iterationNodes[::utils::MAX_PLY] = {};
+
+    void clear() {
+        if constexpr (ENABLED) *this = Counters{};
+    }
+    void add(Counter c) {
+        if constexpr (ENABLED) ++value[c];
+    }
+    void iteration(int depth, uint64_t nodes) {
+        if constexpr (ENABLED) {
+            if (depth < ::utils::MAX_PLY) iterationNodes[depth] = nodes;
+        }
+    }
+    Counters& operator+=(const Counters& o);
+};
+
+// One search thread's view of its last search
+struct ThreadReport {
+    int id = 0;
+    uint64_t nodes = 0;
+    int64_t ms = 0;
+    double pawnHitRate = 0.0;
+    const Counters* counters = nullptr;
+};
+
+// `info string` lines: per-thread nodes/NPS and pawn hash hit rate, then
+// (stats builds only) the counters summed over the threads and the main
+// thread's branching factor per iteration
+void print(std::ostream& os, const std::vector<ThreadReport>& threads);
+
+} // namespace stats
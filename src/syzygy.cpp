@@ -0,0 +1,101 @@
+#include "syzygy.hpp"
+#include "external/fathom/src/tbprobe.h"
+#include <algorithm>
+
+using namespace chess;
+
+namespace {
+
+struct Bitboards {
+    uint64_t white, black, kings, queens, rooks, bishops, knights, pawns;
+    unsigned ep;
+    bool whiteToMove;
+};
+
+bool probeable(const Board& b) {
+    return !b.castlingRights().has(Color::WHITE) && !b.castlingRights().has(Color::BLACK)
+        && b.occ().count() <= (int)TB_LARGEST;
+}
+
+Bitboards bitboards(const Board& b) {
+    return {b.us(Color::WHITE).getBits(),
+            b.us(Color::BLACK).getBits(),
+            b.pieces(PieceType::KING).getBits(),
+            b.pieces(PieceType::QUEEN).getBits(),
+            b.pieces(PieceType::ROOK).getBits(),
+            b.pieces(PieceType::BISHOP).getBits(),
+            b.pieces(PieceType::KNIGHT).getBits(),
+            b.pieces(PieceType::PAWN).getBits(),
+            b.enpassantSq() == Square::NO_SQ ? 0u : (unsigned)b.enpassantSq().index(),
+            b.sideToMove() == Color::WHITE};
+}
+
+// Fathom's promotion code for the piece `m` promotes to (TB_PROMOTES_NONE if none)
+unsigned promotes(Move m) {
+    if (m.typeOf() != Move::PROMOTION) return TB_PROMOTES_NONE;
+    if (m.promotionType() == PieceType::KNIGHT) return TB_PROMOTES_KNIGHT;
+    if (m.promotionType() == PieceType::BISHOP) return TB_PROMOTES_BISHOP;
+    if (m.promotionType() == PieceType::ROOK) return TB_PROMOTES_ROOK;
+    return TB_PROMOTES_QUEEN;
+}
+
+} // namespace
+
+namespace syzygy {
+
+int init(const std::string& path) {
+    tb_init(path.c_str());
+    return (int)TB_LARGEST;
+}
+
+int max_pieces() { return (int)TB_LARGEST; }
+
+bool probe_wdl(const Board& b, WDL& wdl) {
+    if (b.halfMoveClock() != 0 || !probeable(b)) return false;
+    const Bitboards bb = bitboards(b);
+    unsigned r = tb_probe_wdl(bb.white, bb.black, bb.kings, bb.queens, bb.rooks, bb.bishops,
+                              bb.knights, bb.pawns, 0, 0, bb.ep, bb.whiteToMove);
+    if (r == TB_RESULT_FAILED) return false;
+    wdl = (WDL)((int)r - TB_DRAW);
+    return true;
+}
+
+bool probe_root(const Board& b, std::vector<Move>& moves, WDL& wdl) {
+    if (!probeable(b)) return false;
+    const Bitboards bb = bitboards(b);
+    unsigned results[TB_MAX_MOVES];
+    unsigned r = tb_probe_root(bb.white, bb.black, bb.kings, bb.queens, bb.rooks, bb.bishops,
+                               bb.knights, bb.pawns, (unsigned)b.halfMoveClock(), 0, bb.ep,
+                               bb.whiteToMove, results);
+    if (r == TB_RESULT_FAILED || r == TB_RESULT_CHECKMATE || r == TB_RESULT_STALEMATE) return false;
+
+    // Best outcome over the moves, then the best DTZ among the moves reaching it
+    int best = TB_LOSS;
+    for (int i = 0; results[i] != TB_RESULT_FAILED; ++i) best = std::max<int>(best, TB_GET_WDL(results[i]));
+    const bool winning = best > TB_DRAW, losing = best < TB_DRAW;
+    unsigned bestDtz = winning ? ~0u : 0u;
+    for (int i = 0; results[i] != TB_RESULT_FAILED; ++i) {
+        if ((int)TB_GET_WDL(results[i]) != best) continue;
+        const unsigned dtz = TB_GET_DTZ(results[i]);
+        bestDtz = winning ? std::min(bestDtz, dtz) : std::max(bestDtz, dtz);
+    }
+
+    Movelist legal;
+    movegen::legalmoves(legal, b);
+    moves.clear();
+    for (int i = 0; results[i] != TB_RESULT_FAILED; ++i) {
+        const unsigned res = results[i];
+        if ((int)TB_GET_WDL(res) != best || ((winning || losing) && TB_GET_DTZ(res) != bestDtz)) continue;
+        for (const Move& m : legal) {
+            if ((unsigned)m.from().index() == TB_GET_FROM(res) && (unsigned)m.to().index() == TB_GET_TO(res)
+                && promotes(m) == TB_GET_PROMOTES(res)) {
+                moves.push_back(m);
+                break;
+            }
+        }
+    }
+    wdl = (WDL)(best - TB_DRAW);
+    return !moves.empty();
+}
+
+} // namespace syzygy
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "external/chess/include/chess.hpp"
+
+// Syzygy endgame tablebases through Fathom (src/external/fathom). The tables
+// are process-wide: Fathom memory-maps each file the first time a position of
+// that material is probed, and all search threads read the same mappings.
+// init() must not run while a search may probe.
+namespace syzygy {
+
+// Outcome for the side to move; the cursed win and blessed loss are won or
+// lost only without the 50-move rule
+enum WDL : int { LOSS = -2, BLESSED_LOSS = -1, DRAW = 0, CURSED_WIN = 1, WIN = 2 };
+
+// Load the tables found under `path` (directories separated by ':', or ';'
+// on Windows), replacing any loaded before; "" unloads them. Returns the
+// largest number of pieces covered, 0 when none were found.
+int init(const std::string& path);
+
+// Largest number of pieces (kings included) the loaded tables cover, 0 = none
+int max_pieces();
+
+// WDL of `b`. Fails (returns false) if the material is not in the tables or
+// the position has castling rights or a nonzero halfmove clock, since the
+// stored values assume neither.
+bool probe_wdl(const chess::Board& b, WDL& wdl);
+
+// Root moves of `b` that keep the best outcome by DTZ, honouring the
+// halfmove clock: the winning moves that zero the clock soonest, the losing
+// moves that delay it longest, or every drawing move. Fails if `b` is not in
+// the tables or has castling rights.
+bool probe_root(const chess::Board& b, std::vector<chess::Move>& moves, WDL& wdl);
+
+} // namespace syzygy
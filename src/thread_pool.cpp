@@ -0,0 +1,247 @@
+#include "thread_pool.hpp"
+#include "utils.hpp"
+#include <algorithm>
+
+using namespace chess;
+
+ThreadPool::ThreadPool(TranspositionTable& tt) : tt_(tt) {
+    resize(1);
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+    wait();
+    joinAll();
+}
+
+void ThreadPool::resize(int n) {
+    n = std::max(1, n);
+    stop();
+    wait();
+    joinAll();
+    while ((int)workers_.size() > n) workers_.pop_back();
+    while ((int)workers_.size() < n) {
+        auto w = std::make_unique<Worker>();
+        w->search = std::make_unique<Search>(tt_);
+        w->search->setStopFlag(&stop_);
+        w->search->setPonderFlag(&ponder_);
+        w->search->setEvalCache(evalMB_, evalShared_);
+        w->search->setNetwork(net_);
+        w->search->setSyzygyProbeDepth(tbProbeDepth_);
+        workers_.push_back(std::move(w));
+    }
+    workers_[0]->search->setThreadId(0, [this] { return nodes(); }, [this] { return tbHits(); });
+    workers_[0]->search->setOutput(out_);
+    for (int i = 1; i < n; ++i) workers_[i]->search->setThreadId(i);
+    spawn();
+}
+
+void ThreadPool::setEvalCache(size_t mb, bool shared) {
+    wait();
+    evalMB_ = mb;
+    evalShared_ = shared;
+    for (auto& w : workers_) w->search->setEvalCache(mb, shared);
+}
+
+void ThreadPool::setNetwork(const nnue::Network* net) {
+    wait();
+    net_ = net;
+    for (auto& w : workers_) w->search->setNetwork(net);
+}
+
+void ThreadPool::setSyzygyProbeDepth(int depth) {
+    wait();
+    tbProbeDepth_ = depth;
+    for (auto& w : workers_) w->search->setSyzygyProbeDepth(depth);
+}
+
+void ThreadPool::setOutput(output::Queue* out) {
+    wait();
+    out_ = out;
+    workers_[0]->search->setOutput(out);
+}
+
+// The flags change under the mutex so a main thread about to park on held_
+// cannot miss them
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stop_.store(true, std::memory_order_relaxed);
+    }
+    held_.notify_all();
+}
+
+void ThreadPool::ponderhit() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        ponder_.store(false, std::memory_order_relaxed);
+    }
+    held_.notify_all();
+}
+
+void ThreadPool::newGame() {
+    wait();
+    for (auto& w : workers_) w->search->newGame();
+}
+
+void ThreadPool::start(const Board& root, const SearchLimits& lim, DoneFn onDone) {
+    wait();
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        root_ = root;
+        lim_ = lim;
+        onDone_ = std::move(onDone);
+        for (auto& w : workers_) w->result = SearchResult{};
+        stop_.store(false, std::memory_order_relaxed);
+        ponder_.store(lim.ponder, std::memory_order_relaxed);
+        helpersBusy_ = size() - 1;
+        running_.store(size(), std::memory_order_release);
+        ++epoch_;
+    }
+    wake_.notify_all();
+}
+
+void ThreadPool::run(const std::function<void(int)>& task) {
+    wait();
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        task_ = &task;
+        helpersBusy_ = size() - 1;
+        running_.store(size(), std::memory_order_release);
+        ++epoch_;
+    }
+    wake_.notify_all();
+    wait();
+    std::lock_guard<std::mutex> lk(mutex_);
+    task_ = nullptr;
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    done_.wait(lk, [this] { return running_.load(std::memory_order_acquire) == 0; });
+}
+
+uint64_t ThreadPool::nodes() const {
+    uint64_t n = 0;
+    for (const auto& w : workers_) n += w->search->nodes();
+    return n;
+}
+
+uint64_t ThreadPool::tbHits() const {
+    uint64_t n = 0;
+    for (const auto& w : workers_) n += w->search->tbHits();
+    return n;
+}
+
+std::vector<stats::ThreadReport> ThreadPool::reports() const {
+    std::vector<stats::ThreadReport> out;
+    for (int i = 0; i < size(); ++i) {
+        const Search& s = *workers_[i]->search;
+        out.push_back({i, s.nodes(), s.searchMs(), s.pawnTable().hit_rate(), &s.counters()});
+    }
+    return out;
+}
+
+void ThreadPool::spawn() {
+    for (int i = 0; i < size(); ++i) {
+        Worker& w = *workers_[i];
+        w.seen = epoch_;
+        w.thread = std::thread([this, &w, i] { idleLoop(w, i); });
+    }
+}
+
+void ThreadPool::joinAll() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        quit_ = true;
+    }
+    wake_.notify_all();
+    for (auto& w : workers_)
+        if (w->thread.joinable()) w->thread.join();
+    std::lock_guard<std::mutex> lk(mutex_);
+    quit_ = false;
+}
+
+void ThreadPool::idleLoop(Worker& w, int id) {
+    while (true) {
+        const std::function<void(int)>* task;
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            wake_.wait(lk, [&] { return quit_ || epoch_ != w.seen; });
+            if (quit_) return;
+            w.seen = epoch_;
+            task = task_;
+        }
+
+        if (task) {
+            (*task)(id);
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (id != 0) --helpersBusy_;
+            running_.fetch_sub(1, std::memory_order_release);
+            done_.notify_all();
+            continue;
+        }
+
+        Board root = root_; // per-thread copy of the root position
+        w.result = w.search->go(root, lim_);
+
+        std::unique_lock<std::mutex> lk(mutex_);
+        if (id != 0) {
+            --helpersBusy_;
+            running_.fetch_sub(1, std::memory_order_release);
+            done_.notify_all();
+            continue;
+        }
+
+        // Main thread: the search is over once it is, helpers or not. Not
+        // before stop/ponderhit for infinite and ponder searches, though.
+        held_.wait(lk, [this] {
+            return stop_.load(std::memory_order_relaxed)
+                || !(lim_.infinite || ponder_.load(std::memory_order_relaxed));
+        });
+        stop_.store(true, std::memory_order_relaxed);
+        done_.wait(lk, [this] { return helpersBusy_ == 0; });
+        SearchResult best = vote();
+        DoneFn fn = std::move(onDone_);
+        lk.unlock();
+        if (fn) fn(best);
+        lk.lock();
+        running_.fetch_sub(1, std::memory_order_release);
+        done_.notify_all();
+    }
+}
+
+// Each thread votes for its move with weight (score - worst + 14) * depth, so
+// a move backed by several deep, well-scoring iterations beats a lone high
+// score from a shallow helper. Ties go to the main thread.
+SearchResult ThreadPool::vote() const {
+    // MultiPV lines come from the main thread, so its best move stands
+    if (lim_.multiPV > 1) return workers_[0]->result;
+
+    int minScore = ::utils::INF;
+    for (const auto& w : workers_)
+        if (w->result.depth > 0) minScore = std::min(minScore, w->result.bestScore);
+
+    auto votes = [&](const Move& m) {
+        int64_t v = 0;
+        for (const auto& w : workers_) {
+            const SearchResult& r = w->result;
+            if (r.depth > 0 && r.best == m)
+                v += (int64_t)(r.bestScore - minScore + 14) * r.depth;
+        }
+        return v;
+    };
+
+    const SearchResult* best = &workers_[0]->result;
+    int64_t bestVotes = best->depth > 0 ? votes(best->best) : -1;
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        const SearchResult& r = workers_[i]->result;
+        if (r.depth == 0) continue;
+        int64_t v = votes(r.best);
+        if (v > bestVotes || (v == bestVotes && r.depth > best->depth)) {
+            best = &r;
+            bestVotes = v;
+        }
+    }
+    return *best;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "external/chess/include/chess.hpp"
+#include "search.hpp"
+#include "tt.hpp"
+
+// Persistent Lazy SMP pool. One Search per thread, all sharing the TT; the
+// threads stay parked on a condition variable between searches. Thread 0 is
+// the main thread: it alone prints `info` (with node counts summed over the
+// pool) to the output queue, stops the helpers once its own search ends, and
+// picks the final move by voting over every thread's last completed
+// iteration. An infinite or pondering search that runs out of depth holds its
+// result until stop (or ponderhit), as UCI requires, parked on a condition
+// variable that stop() and ponderhit() signal.
+class ThreadPool {
+public:
+    using DoneFn = std::function<void(const SearchResult&)>;
+
+    explicit ThreadPool(TranspositionTable& tt);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of search threads (at least one); waits for a running search
+    void resize(int n);
+    int size() const { return (int)workers_.size(); }
+
+    void setEvalCache(size_t mb, bool shared);
+    // NNUE network for every thread (null = classical eval); waits for a running search
+    void setNetwork(const nnue::Network* net);
+    const nnue::Network* network() const { return net_; }
+    // See Search::setSyzygyProbeDepth; waits for a running search
+    void setSyzygyProbeDepth(int depth);
+    // Queue for the main thread's `info` lines (not owned; null = none). The
+    // pool's main thread is its only producer, `onDone` included.
+    void setOutput(output::Queue* out);
+    void newGame();
+
+    // Start a search of `root` and return at once. `onDone` is called on the
+    // main search thread with the chosen result after all helpers finished.
+    void start(const chess::Board& root, const SearchLimits& lim, DoneFn onDone);
+    void stop();
+    // Switch a `go ponder` search to its normal time budget
+    void ponderhit();
+    // Run `task(threadId)` once on every pool thread; blocks until all return
+    void run(const std::function<void(int)>& task);
+    // Block until the current search (including `onDone`) has completed
+    void wait();
+
+    bool searching() const { return running_.load(std::memory_order_acquire) > 0; }
+    uint64_t nodes() const;
+    uint64_t tbHits() const;
+    // Per-thread figures of the last search; call while no search runs
+    std::vector<stats::ThreadReport> reports() const;
+
+private:
+    struct Worker {
+        std::unique_ptr<Search> search;
+        SearchResult result;
+        std::thread thread;
+        uint64_t seen = 0; // last search epoch this worker picked up
+    };
+
+    void idleLoop(Worker& w, int id);
+    void spawn();
+    void joinAll();
+    SearchResult vote() const;
+
+    TranspositionTable& tt_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> ponder_{false};
+
+    std::mutex mutex_;
+    std::condition_variable wake_;    // workers: a new search or quit
+    std::condition_variable done_;    // waiters: a worker finished
+    std::condition_variable held_;    // main thread holding a result: stop or ponderhit
+    uint64_t epoch_ = 0;              // bumped per search, under mutex_
+    int helpersBusy_ = 0;             // helpers still searching, under mutex_
+    std::atomic<int> running_{0};     // threads still inside the current search
+    bool quit_ = false;
+
+    size_t evalMB_ = 16;
+    bool evalShared_ = false;
+    const nnue::Network* net_ = nullptr;
+    int tbProbeDepth_ = 1;
+    output::Queue* out_ = nullptr;
+
+    chess::Board root_;
+    SearchLimits lim_;
+    DoneFn onDone_;
+    const std::function<void(int)>* task_ = nullptr; // set during run()
+};
@@ -0,0 +1,61 @@
+#include "timeman.hpp"
+#include <algorithm>
+
+TimeManager::Budget TimeManager::budget(int timeLeft, int inc, int movestogo, int overhead) {
+    Budget b;
+    const int avail = std::max(1, timeLeft - overhead);
+
+    // Moves the remaining time has to cover. Without movestogo assume a
+    // horizon of 40; with it, never plan past 50 moves. Overhead is charged
+    // for the next few moves only, or fast games would be left with nothing.
+    const int mtg = movestogo > 0 ? std::min(movestogo, 50) : 40;
+    const int64_t pool = std::max<int64_t>(1, (int64_t)timeLeft + (int64_t)inc * (mtg - 1)
+                                                  - (int64_t)overhead * std::min(mtg, 10));
+
+    // Ceilings as a share of the clock. On the last move of a movestogo cycle
+    // the clock is refilled afterwards, so most of it may be used; otherwise
+    // keep enough back for the moves still to come.
+    double maxShare = movestogo == 1 ? 0.8 : movestogo > 0 ? 0.5 : 0.3;
+    double optShare = movestogo == 1 ? 0.5 : 0.2;
+
+    double opt = std::min((double)pool / mtg, avail * optShare);
+    double max = std::min(opt * (movestogo == 1 ? 1.6 : 4.0), avail * maxShare);
+
+    b.optimum = std::max(1, (int)opt);
+    b.maximum = std::max(b.optimum, (int)max);
+    return b;
+}
+
+void TimeManager::start(int optimum, int maximum) {
+    optimum_ = optimum;
+    maximum_ = std::max(optimum, maximum);
+    iterations_ = 0;
+    lastBest_ = 0;
+    lastScore_ = 0;
+    stableIterations_ = 0;
+    stability_ = scoreTrend_ = nodeShare_ = 1.0;
+}
+
+void TimeManager::update(uint16_t bestMove, int score, double bestMoveNodeFraction) {
+    if (iterations_ > 0) {
+        // Best move unchanged for several iterations: settle sooner
+        stableIterations_ = bestMove == lastBest_ ? stableIterations_ + 1 : 0;
+        stability_ = 1.6 - 0.1 * std::min(stableIterations_, 8);
+
+        // Falling score: something was found against us, think longer
+        int drop = lastScore_ - score;
+        scoreTrend_ = std::clamp(1.0 + drop * 0.01, 0.8, 1.6);
+    }
+
+    // Most of the effort under the best move means the alternatives were
+    // refuted quickly
+    nodeShare_ = (1.5 - std::clamp(bestMoveNodeFraction, 0.0, 1.0)) * 1.25;
+
+    lastBest_ = bestMove;
+    lastScore_ = score;
+    iterations_++;
+}
+
+double TimeManager::target() const {
+    return std::min((double)maximum_, optimum_ * stability_ * scoreTrend_ * nodeShare_);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+// Clock-game time allocation. budget() turns the side to move's clock into an
+// optimum time (what a typical move should take) and a maximum (the hard
+// abort); during the search the main thread feeds each completed iteration
+// to update() and stops deepening once stopAfterIteration() says so.
+class TimeManager {
+public:
+    struct Budget {
+        int optimum = 0;
+        int maximum = 0;
+    };
+
+    // `movestogo` 0 means sudden death (with or without increment).
+    // `overhead` is reserved per remaining move for GUI/network latency.
+    static Budget budget(int timeLeft, int inc, int movestogo, int overhead);
+
+    // Begin a search; scaling applies only when optimum > 0
+    void start(int optimum, int maximum);
+
+    // After each completed iteration: its best move and score, and the share
+    // of all nodes so far spent below that move (0..1)
+    void update(uint16_t bestMove, int score, double bestMoveNodeFraction);
+
+    // True if a new iteration should not be started at `elapsedMs`. An
+    // iteration costs about as much as all earlier ones together, so one
+    // started past ~60% of the scaled target would most likely overrun it.
+    bool stopAfterIteration(int64_t elapsedMs) const {
+        return optimum_ > 0 && elapsedMs >= target() * 0.6;
+    }
+
+    // Scaled time target for this move, never above the maximum
+    double target() const;
+
+private:
+    int optimum_ = 0, maximum_ = 0;
+    int iterations_ = 0;
+    uint16_t lastBest_ = 0;
+    int lastScore_ = 0;
+    int stableIterations_ = 0;
+    double stability_ = 1.0, scoreTrend_ = 1.0, nodeShare_ = 1.0;
+};
@@ -0,0 +1,165 @@
+#include "tt.hpp"
+#include "mapped_file.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr size_t CACHE_LINE = 64;
+constexpr size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+size_t round_up(size_t n, size_t to) { return (n + to - 1) / to * to; }
+
+// Hash file header; the buckets follow in host byte order
+struct FileHeader {
+    char magic[8];          // "MINTT1"
+    uint32_t version;
+    uint32_t bucketSize;
+    uint64_t buckets;
+    uint8_t gen;
+    uint8_t reserved[39];
+};
+static_assert(sizeof(FileHeader) == 64);
+
+constexpr uint32_t FILE_VERSION = 1;
+
+} // namespace
+
+void TranspositionTable::resize(size_t mb) {
+    release();
+    // Members are only set once the allocation has succeeded, so a failed
+    // resize leaves an empty table rather than one that claims `count` buckets
+    const size_t count = std::max<size_t>(sizeof(Bucket), mb * 1024 * 1024) / sizeof(Bucket);
+    const size_t bytes = count * sizeof(Bucket);
+
+    void* mem = nullptr;
+    size_t allocBytes = 0;
+    bool mapped = false;
+#if defined(__linux__)
+    // Explicit huge pages first; this only succeeds when the admin has
+    // reserved them (vm.nr_hugepages), so failure is the common case.
+#if defined(MAP_HUGETLB)
+    if (bytes >= HUGE_PAGE) {
+        allocBytes = round_up(bytes, HUGE_PAGE);
+        void* p = mmap(nullptr, allocBytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) { mem = p; mapped = true; }
+    }
+#endif
+    // Otherwise a 2 MB aligned block the kernel may back with transparent
+    // huge pages
+    if (!mem && bytes >= HUGE_PAGE) {
+        allocBytes = round_up(bytes, HUGE_PAGE);
+        mem = std::aligned_alloc(HUGE_PAGE, allocBytes);
+        if (mem) madvise(mem, allocBytes, MADV_HUGEPAGE);
+    }
+#endif
+    if (!mem) {
+        allocBytes = round_up(bytes, CACHE_LINE);
+        mem = std::aligned_alloc(CACHE_LINE, allocBytes);
+    }
+    if (!mem) throw std::bad_alloc();
+
+    buckets_ = static_cast<Bucket*>(mem);
+    count_ = count;
+    allocBytes_ = allocBytes;
+    mapped_ = mapped;
+    std::uninitialized_default_construct_n(buckets_, count_);
+    gen_ = 0;
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < count_; ++i)
+        for (auto& s : buckets_[i].slots) {
+            s.check.store(0, std::memory_order_relaxed);
+            s.data.store(0, std::memory_order_relaxed);
+        }
+    gen_ = 0;
+}
+
+void TranspositionTable::release() {
+    if (!buckets_) return;
+    std::destroy_n(buckets_, count_);
+#if defined(__linux__)
+    if (mapped_) munmap(buckets_, allocBytes_);
+    else
+#endif
+    std::free(buckets_);
+    buckets_ = nullptr;
+    count_ = 0;
+    allocBytes_ = 0;
+    mapped_ = false;
+}
+
+bool TranspositionTable::save(const std::string& path, std::string& error) const {
+    FileHeader h{};
+    std::memcpy(h.magic, "MINTT1", 6);
+    h.version = FILE_VERSION;
+    h.bucketSize = sizeof(Bucket);
+    h.buckets = count_;
+    h.gen = gen_;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    // One sequential write of the whole table; no search is writing to it
+    out.write(reinterpret_cast<const char*>(buckets_), (std::streamsize)(count_ * sizeof(Bucket)));
+    out.close();
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool TranspositionTable::load(const std::string& path, std::string& error) {
+    MappedFile file(path);
+    if (!file.ok()) {
+        error = "cannot read " + path;
+        return false;
+    }
+    std::string_view data = file.view();
+    FileHeader h;
+    if (data.size() >= sizeof(h)) std::memcpy(&h, data.data(), sizeof(h));
+    if (data.size() < sizeof(h) || std::memcmp(h.magic, "MINTT1", 6) != 0 || h.version != FILE_VERSION
+        || h.bucketSize != sizeof(Bucket) || data.size() - sizeof(h) != h.buckets * sizeof(Bucket)) {
+        error = path + " is not a Minerva hash file (version " + std::to_string(FILE_VERSION) + ")";
+        return false;
+    }
+
+    const char* saved = data.data() + sizeof(h);
+    if (h.buckets == count_) {
+        std::memcpy(static_cast<void*>(buckets_), saved, count_ * sizeof(Bucket));
+    } else {
+        clear();
+        for (size_t i = 0; i < h.buckets * BUCKET_SLOTS; ++i) {
+            uint64_t slot[2]; // check, data
+            std::memcpy(slot, saved + i * sizeof(slot), sizeof(slot));
+            if (slot[1]) restore(slot[0] ^ slot[1], slot[1]);
+        }
+    }
+    gen_ = h.gen & GEN_MASK;
+    return true;
+}
+
+void TranspositionTable::restore(uint64_t key, uint64_t data) {
+    Bucket& b = buckets_[index(key)];
+    Slot* victim = nullptr;
+    int victimDepth = 0;
+    for (auto& s : b.slots) {
+        uint64_t d = s.data.load(std::memory_order_relaxed);
+        int depth = d ? decode(d).depth : -64;
+        if (!victim || depth < victimDepth) {
+            victim = &s;
+            victimDepth = depth;
+        }
+    }
+    if (victimDepth > decode(data).depth) return;
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+}
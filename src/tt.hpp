@@ -1,55 +1,139 @@
 #pragma once
 #include <cstdint>
-#include <vector>
+#include <cstddef>
+#include <algorithm>
 #include <atomic>
+#include <string>
 #include "external/chess/include/chess.hpp"
 #include "utils.hpp"
 
+// Decoded copy of a table slot handed out by probe()
 struct TTEntry {
-    uint64_t key = 0;
     uint16_t move = 0;        // packed
     int16_t  score = 0;       // from side-to-move
     int8_t   depth = -1;
     uint8_t  flag = 0;        // 0=EXACT,1=LOWER,2=UPPER
-    uint8_t  gen  = 0;        // not used much
+    uint8_t  gen  = 0;        // search generation that wrote the entry
 };
 
+// Transposition table shared by all search threads. Slots are grouped into
+// 64-byte buckets (one cache line) and written without locks: each slot keeps
+// key ^ data next to the data word, so a slot torn by a concurrent writer fails
+// verification on probe instead of returning another position's entry.
+// The bucket array is cache-line aligned and backed by huge pages where the OS
+// allows it (see tt.cpp); any bucket count works since indexing is
+// multiply-shift rather than a mask.
 class TranspositionTable {
 public:
+    static constexpr int BUCKET_SLOTS = 4;
+
     explicit TranspositionTable(size_t mb = 64) { resize(mb); }
+    ~TranspositionTable() { release(); }
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
 
-    void resize(size_t mb) {
-        size_t bytes = mb * 1024 * 1024;
-        size_t n = std::max<size_t>(1, bytes / sizeof(TTEntry));
-        table_.assign(n, {});
-        mask_ = n - 1;
-        gen_ = 0;
-    }
+    void resize(size_t mb);
+    void clear();
+
+    void new_generation() { gen_ = (gen_ + 1) & GEN_MASK; }
 
-    void new_generation() { gen_++; }
+    // Write the table to `path`: a 64-byte header ("MINTT1", version, bucket
+    // size and count, generation), then the buckets as they are in memory.
+    // Must not run during a search. On failure returns false and sets `error`.
+    bool save(const std::string& path, std::string& error) const;
+    // Replace the contents with a table written by save(). A table of the
+    // same size is copied as is; otherwise every entry is re-inserted, so the
+    // current size stays. Must not run during a search.
+    bool load(const std::string& path, std::string& error);
 
-    const TTEntry* probe(uint64_t key) const {
-        const TTEntry& e = table_[index(key)];
-        if (e.key == key) return &e;
-        return nullptr;
+    // Start pulling the bucket for `key` into cache; call as soon as the key
+    // of the next node is known, ahead of the probe.
+    void prefetch(uint64_t key) const { __builtin_prefetch(&buckets_[index(key)]); }
+
+    bool probe(uint64_t key, TTEntry& out) const {
+        const Bucket& b = buckets_[index(key)];
+        for (const auto& s : b.slots) {
+            uint64_t data = s.data.load(std::memory_order_relaxed);
+            if ((s.check.load(std::memory_order_relaxed) ^ data) == key && data) {
+                out = decode(data);
+                return true;
+            }
+        }
+        return false;
     }
 
     void store(uint64_t key, uint16_t move, int depth, int score, uint8_t flag) {
-        TTEntry& e = table_[index(key)];
-        if (e.key != key || depth >= e.depth) {
-            e.key = key;
-            e.move = move;
-            e.depth = (int8_t)std::min(depth, 127);
-            e.score = (int16_t)std::max(-::utils::MATE, std::min(::utils::MATE, score));
-            e.flag = flag;
-            e.gen = gen_;
+        Bucket& b = buckets_[index(key)];
+        Slot* victim = nullptr;
+        int victimValue = 0;
+        for (auto& s : b.slots) {
+            uint64_t data = s.data.load(std::memory_order_relaxed);
+            if ((s.check.load(std::memory_order_relaxed) ^ data) == key && data) {
+                TTEntry e = decode(data);
+                // Same position: keep a deeper entry from this search unless
+                // the new result is exact
+                if (depth < e.depth && flag != 0 && e.gen == gen_) return;
+                if (move == 0) move = e.move;
+                victim = &s;
+                break;
+            }
+            // Replace the shallowest entry, treating older generations as
+            // shallower so stale results age out
+            TTEntry e = decode(data);
+            int age = (gen_ - e.gen) & GEN_MASK;
+            int value = (data ? e.depth : -64) - 8 * age;
+            if (!victim || value < victimValue) {
+                victim = &s;
+                victimValue = value;
+            }
         }
+        uint64_t data = encode(move, depth, score, flag);
+        victim->check.store(key ^ data, std::memory_order_relaxed);
+        victim->data.store(data, std::memory_order_relaxed);
     }
 
 private:
-    size_t index(uint64_t key) const { return (size_t)key & mask_; }
+    static constexpr uint8_t GEN_MASK = 0x3F; // 6-bit generation counter
+
+    struct Slot {
+        std::atomic<uint64_t> check{0}; // key ^ data
+        std::atomic<uint64_t> data{0};  // move | score | depth | flag | gen
+    };
+    struct alignas(64) Bucket {
+        Slot slots[BUCKET_SLOTS];
+    };
+    static_assert(sizeof(Bucket) == 64, "bucket must fill one cache line");
+
+    uint64_t encode(uint16_t move, int depth, int score, uint8_t flag) const {
+        int16_t sc = (int16_t)std::max(-::utils::MATE, std::min(::utils::MATE, score));
+        uint8_t d = (uint8_t)(std::clamp(depth, -1, 126) + 1);
+        return (uint64_t)move
+             | (uint64_t)(uint16_t)sc << 16
+             | (uint64_t)d << 32
+             | (uint64_t)(flag & 3) << 40
+             | (uint64_t)gen_ << 42;
+    }
+    static TTEntry decode(uint64_t data) {
+        TTEntry e;
+        e.move  = (uint16_t)data;
+        e.score = (int16_t)(uint16_t)(data >> 16);
+        e.depth = (int8_t)((int)(uint8_t)(data >> 32) - 1);
+        e.flag  = (uint8_t)((data >> 40) & 3);
+        e.gen   = (uint8_t)((data >> 42) & GEN_MASK);
+        return e;
+    }
+
+    // Put a saved slot back into its bucket, over an empty or the shallowest slot
+    void restore(uint64_t key, uint64_t data);
+
+    size_t index(uint64_t key) const {
+        return (size_t)(((unsigned __int128)key * count_) >> 64);
+    }
+    void release();
 
-    std::vector<TTEntry> table_;
-    size_t mask_ = 0;
+    Bucket* buckets_ = nullptr;
+    size_t count_ = 0;
+    size_t allocBytes_ = 0;
+    bool mapped_ = false;     // true when obtained from mmap(MAP_HUGETLB)
     uint8_t gen_ = 0;
 };
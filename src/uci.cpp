@@ -1,27 +1,86 @@
 #include "uci.hpp"
+#include "eval.hpp"
+#include "bench.hpp"
+#include "microbench.hpp"
+#include "perft.hpp"
+#include "stats.hpp"
+#include "syzygy.hpp"
+#include <algorithm>
 #include <iostream>
+#include <new>
 #include <sstream>
-#include <chrono>
-#include <vector>
-#include <memory>
 
 using namespace chess;
 
 UciDriver::UciDriver() {
-    searchers_.emplace_back(std::make_unique<Search>());
-    searchers_[0]->setStopFlag(&stopFlag_);
+    pool_.setOutput(&out_.search());
+    applyEvalCache();
 }
 
 UciDriver::~UciDriver() {
-    stopFlag_.store(true);
-    if (worker_.joinable()) worker_.join();
+    pool_.stop();
+    pool_.wait();
 }
 
-std::string UciDriver::move_to_uci(const Move& m) {
+void UciDriver::applyEvalCache() {
+    pool_.stop();
+    pool_.wait();
+    eval::shared_cache().resize(evalHashShared_ ? evalHashMB_ : 0);
+    pool_.setEvalCache(evalHashMB_, evalHashShared_);
+}
+
+// Point the pool at the network `Eval` and `EvalFile` ask for, loading it on
+// first use; without a usable network the classical eval stays on
+void UciDriver::applyEval() {
+    pool_.stop();
+    pool_.wait();
+    pool_.setNetwork(nullptr);
+    if (useNnue_ && (!net_ || net_->path() != evalFile_)) {
+        net_.reset();
+        std::string error;
+        net_ = nnue::Network::load(evalFile_, error);
+        if (net_) say("info string NNUE network " + evalFile_ + " loaded\n");
+        else say("info string NNUE unavailable, using classical eval: " + error + "\n");
+    }
+    pool_.setNetwork(useNnue_ ? net_.get() : nullptr);
+    // Cached scores came from the other evaluator
+    pool_.newGame();
+    eval::clear_cache();
+}
+
+// Open `BookFile` when `OwnBook` is on and it is not open yet
+void UciDriver::applyBook() {
+    if (!ownBook_ || bookFile_.empty()) {
+        book_.reset();
+        return;
+    }
+    if (book_ && book_->path() == bookFile_) return;
+    std::string error;
+    book_ = Book::open(bookFile_, error);
+    if (book_) say("info string book " + bookFile_ + " opened\n");
+    else say("info string book unavailable: " + error + "\n");
+}
+
+// Answer `go` from the book, if it has a move for the current position.
+// Infinite and ponder searches must wait for stop, so they always search.
+bool UciDriver::playBookMove(const SearchLimits& lim) {
+    if (!book_ || lim.infinite || lim.ponder) return false;
+    Move m = book_->probe(board_, bookBest_);
+    if (m == Move::NO_MOVE) return false;
+    say("info string book move\nbestmove " + move_to_uci(m, chess960_) + "\n");
+    return true;
+}
+
+std::string UciDriver::move_to_uci(const Move& m, bool chess960) {
     if (m == Move::NO_MOVE) return "";
     std::string s;
     auto f = m.from(), t = m.to();
     s += char('a' + f.file()); s += char('1' + f.rank());
+    // Castling is encoded king-takes-rook; standard chess names the king's target
+    if (m.typeOf()==Move::CASTLING && !chess960) {
+        s += (t.index() > f.index()) ? 'g' : 'c'; s += char('1' + f.rank());
+        return s;
+    }
     s += char('a' + t.file()); s += char('1' + t.rank());
     if (m.typeOf()==Move::PROMOTION) {
         auto pt = m.promotionType();
@@ -34,7 +93,7 @@ std::string UciDriver::move_to_uci(const Move& m) {
     return s;
 }
 
-Move UciDriver::uci_to_move(const Board& b, const std::string& u) {
+Move UciDriver::uci_to_move(const Board& b, const std::string& u, bool chess960) {
     if (u.size() < 4) return Move::NO_MOVE;
     Square from(u.substr(0,2));
     Square to(u.substr(2,2));
@@ -50,6 +109,10 @@ Move UciDriver::uci_to_move(const Board& b, const std::string& u) {
 
     Movelist ml; movegen::legalmoves(ml, b);
     for (const auto& m : ml) {
+        if (m.typeOf()==Move::CASTLING) {
+            if (move_to_uci(m, chess960) == u.substr(0, 4)) return m;
+            continue;
+        }
         if (m.from()==from && m.to()==to) {
             if (hasPromo) {
                 if (m.typeOf()==Move::PROMOTION && m.promotionType()==promo) return m;
@@ -62,10 +125,9 @@ Move UciDriver::uci_to_move(const Board& b, const std::string& u) {
 }
 
 void UciDriver::cmd_position(const std::string& line) {
-    // cancel any running search and join worker thread
-    stopFlag_.store(true);
-    if (worker_.joinable()) worker_.join();
-    searching_.store(false);
+    // cancel any running search and wait for the pool to park
+    pool_.stop();
+    pool_.wait();
     auto trim = [](std::string s){
         while(!s.empty() && s.front()==' ') s.erase(s.begin());
         while(!s.empty() && s.back()==' ')  s.pop_back();
@@ -80,7 +142,7 @@ void UciDriver::cmd_position(const std::string& line) {
             std::istringstream iss(rest.substr(mvPos + 5));
             std::string tok;
             while (iss >> tok) {
-                Move m = uci_to_move(board_, tok);
+                Move m = uci_to_move(board_, tok, chess960_);
                 if (m != Move::NO_MOVE) board_.makeMove(m);
                 else break;
             }
@@ -100,7 +162,7 @@ void UciDriver::cmd_position(const std::string& line) {
             std::istringstream iss(rest.substr(movesPos + 5));
             std::string tok;
             while (iss >> tok) {
-                Move m = uci_to_move(board_, tok);
+                Move m = uci_to_move(board_, tok, chess960_);
                 if (m != Move::NO_MOVE) board_.makeMove(m);
                 else break;
             }
@@ -115,11 +177,13 @@ void UciDriver::cmd_position(const std::string& line) {
 SearchLimits UciDriver::parseLimits(const std::string& line) const {
     SearchLimits lim{};
     lim.timeMs = 1000; lim.depth = 0; lim.infinite = false;
+    lim.multiPV = multiPV_;
 
     std::istringstream ss(line);
     std::string tok; ss >> tok; // "go"
     int wtime=-1,btime=-1,winc=0,binc=0,movestogo=-1,movetime=-1,depth=-1;
-    bool infinite=false;
+    long long nodes=-1;
+    bool infinite=false, ponder=false;
 
     while (ss >> tok) {
         if (tok=="wtime") ss >> wtime;
@@ -129,67 +193,77 @@ SearchLimits UciDriver::parseLimits(const std::string& line) const {
         else if (tok=="movestogo") ss >> movestogo;
         else if (tok=="movetime") ss >> movetime;
         else if (tok=="depth") ss >> depth;
+        else if (tok=="nodes") ss >> nodes;
         else if (tok=="infinite") infinite = true;
-        else if (tok=="ponder"||tok=="nodes"||tok=="mate"||tok=="perft") {
+        else if (tok=="ponder") ponder = true;
+        else if (tok=="mate") {
             std::string dummy; ss >> dummy;
         }
     }
 
-    if (infinite) { lim.infinite = true; lim.timeMs = 24*60*60*1000; return lim; }
-    if (movetime > 0) { lim.timeMs = movetime; return lim; }
-    if (depth > 0) { lim.depth = depth; lim.timeMs = 30*1000; return lim; }
+    if (depth > 0) lim.depth = depth;
+    if (nodes > 0) lim.nodes = (uint64_t)nodes;
 
     bool whiteToMove = (board_.sideToMove()==Color::WHITE);
     int myTime = whiteToMove ? wtime : btime;
     int myInc  = whiteToMove ? winc  : binc;
 
+    lim.ponder = ponder;
+    if (infinite) { lim.infinite = true; lim.timeMs = 24*60*60*1000; return lim; }
+    if (movetime > 0) { lim.timeMs = movetime; return lim; }
+    if (myTime < 0 && nodes > 0) { lim.timeMs = 24*60*60*1000; return lim; }
+    if (myTime < 0 && depth > 0) { lim.timeMs = 30*1000; return lim; }
+
     if (myTime >= 0) {
-        int mtg = (movestogo>0 ? movestogo : 30);
-        int slice = myTime / std::max(1, mtg);
-        int budget = slice + myInc/2;
-        lim.timeMs = std::clamp(budget, 20, std::max(50, myTime-10));
+        auto budget = TimeManager::budget(myTime, myInc, std::max(0, movestogo), moveOverheadMs_);
+        lim.softMs = budget.optimum;
+        lim.timeMs = budget.maximum;
     } else {
         lim.timeMs = 500;
     }
     return lim;
 }
 
-void UciDriver::cmd_go(const std::string& line) {
-    // ensure previous search thread finished
-    stopFlag_.store(true);
-    if (worker_.joinable()) worker_.join();
-    searching_.store(false);
-    SearchLimits lim = parseLimits(line);
-    stopFlag_.store(false);
-    searching_.store(true);
+void UciDriver::cmd_perft(int depth, size_t hashMB) {
+    pool_.stop();
+    pool_.wait();
+    out_.flush(); // perft prints through std::cout
+    perft::divide(board_, depth, pool_, hashMB, chess960_);
+}
 
-    // Ensure we have enough persistent searchers
-    if ((int)searchers_.size() < threads_) {
-        while ((int)searchers_.size() < threads_) {
-            searchers_.emplace_back(std::make_unique<Search>());
-            searchers_.back()->setStopFlag(&stopFlag_);
-        }
-    } else if ((int)searchers_.size() > threads_) {
-        searchers_.resize(threads_);
-    }
+// Save the TT to / load it from `path` (HashFile when empty), once the pool
+// has parked
+void UciDriver::cmd_hashfile(bool save, const std::string& path) {
+    pool_.stop();
+    pool_.wait();
+    const std::string& file = path.empty() ? hashFile_ : path;
+    std::string error;
+    if (file.empty()) error = "no hash file given";
+    else if (save ? tt_.save(file, error) : tt_.load(file, error))
+        say("info string hash " + std::string(save ? "saved to " : "loaded from ") + file + "\n");
+    if (!error.empty()) say("info string " + error + "\n");
+}
 
-    // Fire worker
-    worker_ = std::thread([this, lim]() {
-        std::vector<SearchResult> results(threads_);
-        std::vector<std::thread> ths;
-        for (int i = 0; i < threads_; ++i) {
-            ths.emplace_back([&, i]() {
-                results[i] = searchers_[i]->go(board_, lim);
-            });
-        }
-        for (auto& t : ths) t.join();
+void UciDriver::cmd_go(const std::string& line) {
+    // go perft N: move generation count instead of a search
+    {
+        std::istringstream ss(line);
+        std::string tok;
+        int depth = 0;
+        ss >> tok >> tok;
+        if (tok == "perft" && ss >> depth) { cmd_perft(depth, 16); return; }
+    }
 
-        SearchResult best = results[0];
-        for (int i = 1; i < threads_; ++i) {
-            if (results[i].bestScore > best.bestScore)
-                best = results[i];
-        }
+    // ensure the previous search finished
+    pool_.stop();
+    pool_.wait();
+    SearchLimits lim = parseLimits(line);
+    if (playBookMove(lim)) return;
+    tt_.new_generation();
 
+    // bestmove is printed by the pool's main thread once every thread is done
+    pool_.start(board_, lim, [this](const SearchResult& res) {
+        SearchResult best = res;
         Movelist legal; movegen::legalmoves(legal, board_);
         bool found = false;
         for (const auto& m : legal) {
@@ -200,11 +274,29 @@ void UciDriver::cmd_go(const std::string& line) {
             else best.best = Move::NO_MOVE;
         }
 
-        std::string bm = move_to_uci(best.best);
-        if (bm.empty() && !legal.empty()) bm = move_to_uci(legal.front());
+        std::string bm = move_to_uci(best.best, chess960_);
+        if (bm.empty() && !legal.empty()) bm = move_to_uci(legal.front(), chess960_);
         if (bm.empty()) bm = "0000";
-        std::cout << "bestmove " << bm << "\n" << std::flush;
-        searching_.store(false);
+
+        // Expected reply: second PV move, else the TT move after our move
+        std::string pm;
+        if (best.best != Move::NO_MOVE) {
+            Board after = board_;
+            after.makeMove(best.best);
+            Move reply = best.ponder;
+            TTEntry e;
+            if (reply == Move::NO_MOVE && tt_.probe(after.hash(), e)) reply = Move(e.move);
+            Movelist replies; movegen::legalmoves(replies, after);
+            for (const auto& m : replies)
+                if (reply != Move::NO_MOVE && m.move() == reply.move()) pm = move_to_uci(m, chess960_);
+        }
+        // Stats builds report the search's counters with every move
+        if constexpr (stats::ENABLED) {
+            std::ostringstream os;
+            stats::print(os, pool_.reports());
+            out_.search().push(os.str());
+        }
+        out_.search().push("bestmove " + bm + (pm.empty() ? "" : " ponder " + pm) + "\n");
     });
 }
 
@@ -215,14 +307,34 @@ int UciDriver::loop() {
     std::string line;
     while (std::getline(std::cin, line)) {
         if (line == "uci") {
-            std::cout << "id name Minerva-Classic\n";
-            std::cout << "id author Mihnea-Teodor Stoica\n";
-            // Optionally: declare "Hash" here and wire to tt_.resize().
-            std::cout << "uciok\n" << std::flush;
+            say("id name Minerva-Classic\n"
+                "id author Mihnea-Teodor Stoica\n"
+                "option name Hash type spin default 64 min 1 max 65536\n"
+                "option name Clear Hash type button\n"
+                "option name HashFile type string default <empty>\n"
+                "option name SaveHash type button\n"
+                "option name LoadHash type button\n"
+                "option name Threads type spin default 1 min 1 max 256\n"
+                "option name EvalHash type spin default 16 min 1 max 4096\n"
+                "option name EvalHashShared type check default false\n"
+                "option name Move Overhead type spin default 30 min 0 max 5000\n"
+                "option name MultiPV type spin default 1 min 1 max 256\n"
+                "option name Eval type combo default Classical var Classical var NNUE\n"
+                "option name EvalFile type string default <empty>\n"
+                "option name OwnBook type check default false\n"
+                "option name BookFile type string default <empty>\n"
+                "option name BookSelection type combo default Weighted var Weighted var Best\n"
+                "option name SyzygyPath type string default <empty>\n"
+                "option name SyzygyProbeDepth type spin default 1 min 1 max 100\n"
+                "uciok\n");
         } else if (line == "isready") {
-            std::cout << "readyok\n" << std::flush;
+            say("readyok\n");
         } else if (line == "ucinewgame") {
-            for (auto& s : searchers_) s->newGame();
+            pool_.stop();
+            pool_.wait();
+            pool_.newGame();
+            tt_.clear();
+            eval::clear_cache();
         } else if (line.rfind("setoption",0)==0) {
             std::istringstream ss(line);
             std::string token, name, value;
@@ -233,33 +345,138 @@ int UciDriver::loop() {
                 name += token;
             }
             if (token == "value") ss >> value;
-            if (name == "Threads") {
-                int t = 1;
-                try { t = std::stoi(value); } catch (...) { t = 1; }
-                threads_ = std::max(1, t);
-                if ((int)searchers_.size() < threads_) {
-                    while ((int)searchers_.size() < threads_) {
-                        searchers_.emplace_back(std::make_unique<Search>());
-                        searchers_.back()->setStopFlag(&stopFlag_);
+            if (name == "Hash") {
+                int mb = 64;
+                try { mb = std::stoi(value); } catch (...) { mb = 64; }
+                pool_.stop();
+                pool_.wait();
+                // Halve the request until it fits; the table is never left
+                // empty, since probes assume at least one bucket
+                size_t want = (size_t)std::clamp(mb, 1, 65536), got = want;
+                while (true) {
+                    try { tt_.resize(got); break; }
+                    catch (const std::bad_alloc&) {
+                        if (got == 1) throw;
+                        got /= 2;
                     }
-                } else if ((int)searchers_.size() > threads_) {
-                    searchers_.resize(threads_);
                 }
+                if (got != want)
+                    say("info string Hash " + std::to_string(want) + " MB unavailable, using "
+                        + std::to_string(got) + " MB\n");
+            } else if (name == "Clear Hash") {
+                pool_.stop();
+                pool_.wait();
+                tt_.clear();
+            } else if (name == "HashFile") {
+                size_t at = line.find(" value ");
+                hashFile_ = at == std::string::npos ? "" : line.substr(at + 7);
+                if (hashFile_ == "<empty>") hashFile_.clear();
+            } else if (name == "SaveHash" || name == "LoadHash") {
+                cmd_hashfile(name == "SaveHash", "");
+            } else if (name == "Threads") {
+                int t = 1;
+                try { t = std::stoi(value); } catch (...) { t = 1; }
+                pool_.resize(std::clamp(t, 1, 256));
+            } else if (name == "EvalHash") {
+                int mb = 16;
+                try { mb = std::stoi(value); } catch (...) { mb = 16; }
+                evalHashMB_ = std::clamp(mb, 1, 4096);
+                applyEvalCache();
+            } else if (name == "MultiPV") {
+                int k = 1;
+                try { k = std::stoi(value); } catch (...) { k = 1; }
+                multiPV_ = std::clamp(k, 1, 256);
+            } else if (name == "Move Overhead") {
+                int ms = 30;
+                try { ms = std::stoi(value); } catch (...) { ms = 30; }
+                moveOverheadMs_ = std::clamp(ms, 0, 5000);
+            } else if (name == "Eval") {
+                useNnue_ = (value == "NNUE");
+                applyEval();
+            } else if (name == "EvalFile") {
+                size_t at = line.find(" value ");
+                evalFile_ = at == std::string::npos ? "" : line.substr(at + 7);
+                if (evalFile_ == "<empty>") evalFile_.clear();
+                if (useNnue_) applyEval();
+            } else if (name == "OwnBook") {
+                ownBook_ = (value == "true");
+                applyBook();
+            } else if (name == "BookFile") {
+                size_t at = line.find(" value ");
+                bookFile_ = at == std::string::npos ? "" : line.substr(at + 7);
+                if (bookFile_ == "<empty>") bookFile_.clear();
+                applyBook();
+            } else if (name == "BookSelection") {
+                bookBest_ = (value == "Best");
+            } else if (name == "SyzygyPath") {
+                // The value may contain spaces
+                size_t at = line.find(" value ");
+                std::string path = at == std::string::npos ? "" : line.substr(at + 7);
+                if (path == "<empty>") path.clear();
+                pool_.stop();
+                pool_.wait();
+                int pieces = syzygy::init(path);
+                if (pieces) say("info string Syzygy tablebases up to " + std::to_string(pieces) + " pieces\n");
+                else if (!path.empty()) say("info string no Syzygy tablebases found in " + path + "\n");
+            } else if (name == "SyzygyProbeDepth") {
+                int d = 1;
+                try { d = std::stoi(value); } catch (...) { d = 1; }
+                pool_.setSyzygyProbeDepth(std::clamp(d, 1, 100));
+            } else if (name == "EvalHashShared") {
+                evalHashShared_ = (value == "true");
+                applyEvalCache();
             }
-            // For future: parse other setoption like "Hash".
         } else if (line.rfind("position",0)==0) {
             cmd_position(line);
         } else if (line.rfind("go",0)==0) {
             cmd_go(line);
+        } else if (line == "ponderhit") {
+            pool_.ponderhit();
         } else if (line == "stop") {
-            stopFlag_.store(true);
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            pool_.stop();
         } else if (line == "quit") {
-            stopFlag_.store(true);
-            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            // Stop and join the search; its bestmove is queued before ~UciDriver
+            // writes out the queues
+            pool_.stop();
+            pool_.wait();
             break;
+        } else if (line.rfind("perft",0)==0) {
+            // perft N [hashMB]; hashMB 0 disables the perft hash
+            std::istringstream ss(line);
+            std::string token;
+            int depth = 1, hashMB = 16;
+            ss >> token >> depth >> hashMB;
+            cmd_perft(depth, (size_t)std::max(0, hashMB));
+        } else if (line.rfind("savehash",0)==0 || line.rfind("loadhash",0)==0) {
+            // savehash|loadhash [file]; the file defaults to HashFile
+            size_t at = line.find(' ');
+            cmd_hashfile(line[0] == 's', at == std::string::npos ? "" : line.substr(at + 1));
+        } else if (line.rfind("bench",0)==0) {
+            pool_.stop();
+            pool_.wait();
+            std::istringstream ss(line);
+            std::string token;
+            int depth = 10, threads = 1, hashMB = 16;
+            ss >> token >> depth >> threads >> hashMB;
+            out_.flush();
+            bench::run(depth, threads, (size_t)std::max(1, hashMB), pool_.network());
+        } else if (line.rfind("microbench",0)==0) {
+            std::istringstream ss(line);
+            std::string token, name;
+            ss >> token >> name;
+            out_.flush();
+            microbench::run(name);
+        } else if (line == "stats") {
+            // Figures of the last search; a running one is not interrupted
+            if (pool_.searching()) {
+                say("info string stats unavailable while searching\n");
+            } else {
+                std::ostringstream os;
+                stats::print(os, pool_.reports());
+                say(os.str());
+            }
         } else if (line=="d" || line=="print") {
-            std::cout << "info string FEN " << board_.getFen() << "\n";
+            say("info string FEN " + board_.getFen() + "\n");
         }
     }
     return 0;
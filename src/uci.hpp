@@ -1,11 +1,12 @@
 #pragma once
-#include <string>
-#include <thread>
-#include <atomic>
-#include <vector>
 #include <memory>
+#include <string>
 #include "external/chess/include/chess.hpp"
+#include "book.hpp"
+#include "nnue.hpp"
+#include "output.hpp"
 #include "search.hpp"
+#include "thread_pool.hpp"
 
 class UciDriver {
 public:
@@ -14,21 +15,46 @@ public:
 
     int loop(); // returns exit code
 
+    // UCI move strings; castling is written king-to-target unless chess960
+    static std::string move_to_uci(const chess::Move& m, bool chess960 = false);
+    static chess::Move uci_to_move(const chess::Board& b, const std::string& u, bool chess960 = false);
+
 private:
     void cmd_position(const std::string& line);
     void cmd_go(const std::string& line);
     SearchLimits parseLimits(const std::string& line) const;
-
-    static std::string move_to_uci(const chess::Move& m);
-    static chess::Move uci_to_move(const chess::Board& b, const std::string& u);
+    void applyEvalCache();
+    void applyEval();
+    void applyBook();
+    bool playBookMove(const SearchLimits& lim);
+    void cmd_perft(int depth, size_t hashMB);
+    void cmd_hashfile(bool save, const std::string& path);
+    // Queue text of the command thread; search threads use out_.search()
+    void say(std::string_view s) { out_.control().push(s); }
 
 private:
     chess::Board board_{chess::constants::STARTPOS};
     bool chess960_ = false;
 
-    std::vector<std::unique_ptr<Search>> searchers_;
-    std::thread worker_;
-    std::atomic<bool> stopFlag_{false};
-    std::atomic<bool> searching_{false};
-    int threads_ = 1;
+    // All output goes through here; declared first so it is written out and
+    // joined only after the pool has stopped
+    output::Writer out_;
+
+    // Declared before the pool, which points into it, so it outlives the searches
+    std::unique_ptr<nnue::Network> net_;
+    std::string evalFile_;
+    bool useNnue_ = false;
+
+    std::unique_ptr<Book> book_;
+    std::string bookFile_;
+    bool ownBook_ = false;
+    bool bookBest_ = false; // BookSelection: highest weight instead of weighted random
+
+    TranspositionTable tt_{64};
+    std::string hashFile_; // default file of SaveHash/LoadHash
+    ThreadPool pool_{tt_};
+    int evalHashMB_ = 16;
+    bool evalHashShared_ = false;
+    int moveOverheadMs_ = 30;
+    int multiPV_ = 1;
 };
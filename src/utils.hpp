@@ -7,19 +7,30 @@ namespace utils {
 constexpr int INF  = 30000;
 constexpr int MATE = 32000;
 constexpr int MATE_IN_MAX = 10000; // distance windowing
+constexpr int MAX_PLY = 128;       // search stack depth
+// Tablebase win, less the ply it was found at; below every mate score
+constexpr int TB_WIN = MATE - MATE_IN_MAX - 1;
+constexpr int TB_WIN_IN_MAX_PLY = TB_WIN - MAX_PLY;
 
 inline int mate_score(int plies_to_mate) { return MATE - plies_to_mate; }
 inline bool is_mate_score(int s) { return s > MATE - MATE_IN_MAX || s < -MATE + MATE_IN_MAX; }
+// Full moves to mate for a mate score (negative when being mated), else 0
+inline int mate_moves(int s) {
+    if (s > MATE - MATE_IN_MAX) return (MATE - s + 1) / 2;
+    if (s < -MATE + MATE_IN_MAX) return -(MATE + s) / 2;
+    return 0;
+}
 
-// Convert score for TT storage/restore to keep mate distance consistent
+// Convert score for TT storage/restore to keep mate and tablebase distances
+// consistent
 inline int to_tt(int score, int ply) {
-    if (score > MATE - MATE_IN_MAX) return score + ply;
-    if (score < -MATE + MATE_IN_MAX) return score - ply;
+    if (score >= TB_WIN_IN_MAX_PLY) return score + ply;
+    if (score <= -TB_WIN_IN_MAX_PLY) return score - ply;
     return score;
 }
 inline int from_tt(int score, int ply) {
-    if (score > MATE - MATE_IN_MAX) return score - ply;
-    if (score < -MATE + MATE_IN_MAX) return score + ply;
+    if (score >= TB_WIN_IN_MAX_PLY) return score - ply;
+    if (score <= -TB_WIN_IN_MAX_PLY) return score + ply;
     return score;
 }
 
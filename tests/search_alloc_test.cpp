@@ -0,0 +1,63 @@
+// Heap allocations made by Search::go(). Below the root the search must not
+// allocate: per-ply state lives on the preallocated SearchStack. Once per
+// search the root copy of the board (and its move history as it grows) and
+// the result's PV may allocate, so each search is allowed a small fixed
+// number of allocations however many nodes it visits.
+//
+// Build and run with ./build.sh test
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <new>
+#include "external/chess/include/chess.hpp"
+#include "search.hpp"
+#include "tt.hpp"
+
+namespace {
+
+uint64_t g_allocs = 0; // the searches run on this thread only
+
+constexpr uint64_t ALLOWANCE = 16;
+
+const char* const POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+};
+
+} // namespace
+
+void* operator new(std::size_t n) {
+    ++g_allocs;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main() {
+    TranspositionTable tt(16);
+    auto search = std::make_unique<Search>(tt);
+    SearchLimits lim;
+    lim.depth = 9;
+    lim.timeMs = std::numeric_limits<int>::max();
+    lim.quiet = true;
+
+    int failures = 0;
+    for (const char* fen : POSITIONS) {
+        chess::Board b(fen);
+        search->go(b, lim); // warm-up: lazily sized buffers settle here
+        tt.new_generation();
+        const uint64_t before = g_allocs;
+        search->go(b, lim);
+        const uint64_t allocs = g_allocs - before;
+        const bool ok = allocs <= ALLOWANCE;
+        std::printf("%-8s %-72s %9llu nodes %4llu allocations\n", ok ? "ok" : "FAILED", fen,
+                    (unsigned long long)search->nodes(), (unsigned long long)allocs);
+        failures += !ok;
+    }
+    return failures ? 1 : 0;
+}